@@ -0,0 +1,21 @@
+#ifndef _AUXV_H_
+#define _AUXV_H_
+
+//
+// types of the entries of the auxiliary vector, which the kernel places on the user stack
+// after envp[] (see ustack_init() in kernel/ustack.c). the ones Linux also has keep its
+// numbers; those of PKE start at AT_PKE_BASE, beyond the range Linux uses.
+//
+#define AT_NULL 0    // the end of the vector
+#define AT_PAGESZ 6  // page size in bytes
+#define AT_ENTRY 9   // entry point of the application
+#define AT_HWCAP 16  // extensions the user may use, bit (letter - 'A') as in misa: F, D and V
+#define AT_CLKTCK 17 // kernel timer ticks per second
+
+#define AT_PKE_BASE 0x1000
+#define AT_PKE_NHARTS (AT_PKE_BASE + 0)         // harts the kernel runs on
+#define AT_PKE_CLOCK_FREQ (AT_PKE_BASE + 1)     // Hz of the cycle counter, 0 if not known
+#define AT_PKE_TIMEBASE_FREQ (AT_PKE_BASE + 2)  // Hz of the time counter (rdtime)
+#define AT_PKE_KINFO (AT_PKE_BASE + 3)          // address of the kinfo page, see kernel/kinfo.h
+
+#endif
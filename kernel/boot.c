@@ -0,0 +1,54 @@
+/*
+ * boot-phase timing. the boot path stamps g_boot_record with the cycle counter as it goes
+ * (see boot_mark()), and the record is reported just before the first user instruction.
+ */
+
+#include "boot.h"
+#include "config.h"
+#include "util/snprintf.h"
+
+#include "spike_interface/spike_utils.h"
+
+// written by _mentry, before any C code runs, so it must not be moved out of .bss.
+boot_record g_boot_record;
+
+static const char *phase_names[BOOT_NPHASES] = {
+    [BOOT_MENTRY] = "_mentry",
+    [BOOT_MSTART] = "m_start",
+    [BOOT_FILE_INIT] = "spike_file_init",
+    [BOOT_DTB] = "init_dtb",
+    [BOOT_SSTART] = "s_start",
+    [BOOT_ELF_OPEN] = "elf open",
+    [BOOT_ELF_HEADER] = "elf header",
+    [BOOT_ELF_LOAD] = "elf segments",
+    [BOOT_ELF_CLOSE] = "elf close",
+    [BOOT_USER] = "return_to_user",
+};
+
+static void write_json(const char *path) {
+  spike_file_t *f = spike_file_open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (IS_ERR_VALUE(f)) {
+    sprint("boot record: can not create %s.\n", path);
+    return;
+  }
+
+  char buf[1024];
+  int n = snprintf(buf, sizeof(buf), "{\"unit\": \"cycles\", \"phases\": [");
+  for (int i = 0; i < BOOT_NPHASES && n < sizeof(buf); i++)
+    n += snprintf(buf + n, sizeof(buf) - n, "%s\n  {\"name\": \"%s\", \"cycles\": %ld}",
+                  i ? "," : "", phase_names[i], g_boot_record.cycles[i]);
+  if (n < sizeof(buf)) n += snprintf(buf + n, sizeof(buf) - n, "\n]}\n");
+  spike_file_write(f, buf, n < sizeof(buf) ? n : sizeof(buf) - 1);
+  spike_file_close(f);
+}
+
+void boot_report(void) {
+  const uint64 *c = g_boot_record.cycles;
+
+  sprint("Boot timing (cycles):\n");
+  sprint("  %-16s %12s %12s\n", "phase", "delta", "since entry");
+  for (int i = 0; i < BOOT_NPHASES; i++)
+    sprint("  %-16s %12ld %12ld\n", phase_names[i], i ? c[i] - c[i - 1] : 0, c[i] - c[0]);
+
+  if (BOOT_RECORD_PATH[0]) write_json(BOOT_RECORD_PATH);
+}
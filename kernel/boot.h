@@ -0,0 +1,35 @@
+#ifndef _BOOT_H_
+#define _BOOT_H_
+
+#include "util/types.h"
+#include "riscv.h"
+
+// the steps of booting PKE, in the order they happen
+typedef enum boot_phase_t {
+  BOOT_MENTRY = 0,   // _mentry, the first instruction (recorded in kernel/machine/mentry.S)
+  BOOT_MSTART,       // m_start()
+  BOOT_FILE_INIT,    // spike_file_init() done
+  BOOT_DTB,          // init_dtb() done
+  BOOT_SSTART,       // s_start()
+  BOOT_ELF_OPEN,     // application file opened
+  BOOT_ELF_HEADER,   // elf header read
+  BOOT_ELF_LOAD,     // segments loaded
+  BOOT_ELF_CLOSE,    // application file closed
+  BOOT_USER,         // first return_to_user()
+  BOOT_NPHASES,
+} boot_phase;
+
+// cycle counter at the end of each boot phase
+typedef struct boot_record_t {
+  uint64 cycles[BOOT_NPHASES];
+} boot_record;
+
+extern boot_record g_boot_record;
+
+// read_cycle() is defined in kernel/riscv.h, it works in both M and S modes
+#define boot_mark(phase) (g_boot_record.cycles[phase] = read_cycle())
+
+// print the boot record as a table, and write it to BOOT_RECORD_PATH if configured
+void boot_report(void);
+
+#endif
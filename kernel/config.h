@@ -6,15 +6,90 @@
 
 #define DRAM_BASE 0x80000000
 
-/* we use fixed physical (also logical) addresses for the stacks and trap frames as in
- Bare memory-mapping mode */
-// user stack top
-#define USER_STACK 0x81100000
+/* in Bare memory-mapping mode, physical (also logical) addresses of the user program, its
+ stacks and its trap frame are decided at boot from the memory size found in the DTB.
+ see pmm_init() in kernel/pmm.c */
+// user applications are linked at USER_BASE (see user/user.lds). the memory below it (after
+// the kernel image) is managed by the kernel, the memory above it belongs to the user.
+#define USER_BASE 0x81000000
 
-// the stack used by PKE kernel when a syscall happens
-#define USER_KSTACK 0x81200000
+// the kernel stack takes the KSTACK_SIZE bytes right below USER_BASE. the KSTACK_GUARD_SIZE
+// bytes below it are denied to S-mode (see pmp_init() in kernel/machine/minit.c), so that an
+// overflow faults instead of running into the kernel free pages. included by assembly too.
+#define KSTACK_SIZE 0x8000
+#define KSTACK_GUARD_SIZE 0x1000
+#define KSTACK_GUARD (USER_BASE - KSTACK_SIZE - KSTACK_GUARD_SIZE)
 
-// the trap frame used to assemble the user "process"
-#define USER_TRAP_FRAME 0x81300000
+// the user stack sits at the top of the emulated memory, and takes 1/USER_STACK_FRACTION of
+// the user memory, but no less than USER_STACK_MIN bytes
+#define USER_STACK_FRACTION 8
+#define USER_STACK_MIN 0x100000
+
+// a process starts with USER_STACK_INITIAL bytes of stack (plus its arguments), and the stack
+// grows on demand into the region above, up to USER_STACK_RLIMIT bytes. the USER_STACK_GUARD
+// bytes below the stack in use fault on access (see kernel/ustack.c).
+#define USER_STACK_INITIAL 0x1000
+#define USER_STACK_RLIMIT 0x800000
+#define USER_STACK_GUARD 0x10000
+
+// named shared memory (kernel/shm.c) is carved from the top of the user program region,
+// right below the user stack: SHM_SIZE bytes, in at most SHM_MAX_REGIONS regions
+#define SHM_SIZE 0x400000
+#define SHM_MAX_REGIONS 16
+
+// number of records in the trace ring of each hart (kernel/trace.c), must be a power of 2
+#define TRACE_RING_SIZE 1024
+
+// print the trace rings on the console at shutdown. they are always printed on panic.
+#define TRACE_DRAIN_ON_SHUTDOWN 0
+
+// at shutdown, also write the trace rings as Chrome trace_event JSON (for chrome://tracing
+// or Perfetto) to this host file, unless empty
+#define TRACE_CHROME_PATH ""
+
+// timer ticks per second. the interval is derived from the timebase frequency in the DTB,
+// or is TIMER_INTERVAL_DEFAULT (in mtime units) if the DTB has none.
+#define TIMER_HZ 1000
+#define TIMER_INTERVAL_DEFAULT 10000
+// interrupt only when a kernel timer expires (kernel/timer.c), instead of on every tick.
+// the profiler needs every tick, and turns this off.
+#define TIMER_TICKLESS 1
+
+// CLINT base address of spike, used when the DTB does not describe a CLINT
+#define CLINT_BASE_DEFAULT 0x2000000
+
+// sample the interrupted pc on every timer tick, and write a profile (kernel/profile.c) of
+// the run to PROFILE_PATH on the host at shutdown
+#define PROFILE_ENABLE 0
+#define PROFILE_PATH "pke_profile.folded"
+// number of samples kept per hart, and symbols kept per ELF image (kernel, application)
+#define PROFILE_MAX_SAMPLES 16384
+#define PROFILE_MAX_SYMS 1024
+#define PROFILE_MAX_NAMES 16384
+
+// give a process its FP registers back as soon as it is switched in, if it used FP before,
+// instead of on its first FP instruction (see kernel/fp.c)
+#define FP_EAGER_RESTORE 0
+
+// the console of the user processes (kernel/console.c) is the NS16550 UART of the DTB, if
+// there is one, driven by interrupts with a transmit and a receive ring of these sizes
+// (powers of 2). the baud rate is set if the DTB tells the clock of the UART.
+#define UART_TX_BUF 4096
+#define UART_RX_BUF 1024
+#define UART_BAUD 115200
+
+// the harts (bit h for hart h) that take the interrupts of the devices, e.g., to keep I/O
+// off the harts busy with computation, and the PLIC priority (1-7) of the UART
+#define PLIC_IO_HARTS 0x1
+#define UART_IRQ_PRIORITY 1
+
+// the boot record (kernel/boot.c) is also written as JSON to this host file, unless empty
+#define BOOT_RECORD_PATH ""
+
+// time the string routines of the kernel at boot (kernel/kmem_bench.c). "make bench" builds
+// a kernel with -DKMEM_BENCH=1 for this.
+#ifndef KMEM_BENCH
+#define KMEM_BENCH 0
+#endif
 
 #endif
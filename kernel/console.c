@@ -0,0 +1,30 @@
+/*
+ * the console of the user processes, behind their descriptors 0-2: the NS16550 UART
+ * (kernel/uart.c) when the platform has one, else the host console through HTIF.
+ * the messages of the kernel itself (sprint()) always go through HTIF.
+ */
+
+#include "console.h"
+#include "uart.h"
+
+#include "spike_interface/spike_utils.h"
+
+static int on_uart;
+
+void console_init(void) {
+  // uart_init() is defined in kernel/uart.c
+  on_uart = uart_init();
+  if (on_uart)
+    sprint("Console on the UART at 0x%lx, irq %d\n", g_platform.uart.base, g_platform.uart_irq);
+}
+
+int64 console_read(char *buf, uint64 n) {
+  if (on_uart) return uart_read(buf, n);
+  // the host file read waits for the input, with the whole machine
+  return spike_file_read(stdin, buf, n);
+}
+
+int64 console_write(const char *buf, uint64 n) {
+  if (on_uart) return uart_write(buf, n);
+  return spike_file_write(stdout, buf, n);
+}
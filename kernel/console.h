@@ -0,0 +1,16 @@
+#ifndef _CONSOLE_H_
+#define _CONSOLE_H_
+
+#include "util/types.h"
+
+// file descriptors 0, 1 and 2 of every process are the console: stdin, stdout and stderr
+#define CONSOLE_NFDS 3
+
+// use the UART for the console if the platform has one, else HTIF
+void console_init(void);
+// read up to n bytes, waiting for at least one. returns the number read, or -1.
+int64 console_read(char *buf, uint64 n);
+// returns the number of bytes written, or -1
+int64 console_write(const char *buf, uint64 n);
+
+#endif
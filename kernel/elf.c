@@ -6,8 +6,24 @@
 #include "elf.h"
 #include "string.h"
 #include "riscv.h"
+#include "pmm.h"
+#include "trace.h"
+#include "profile.h"
+#include "boot.h"
+#include "preempt.h"
+#include "ustack.h"
+#include "kinfo.h"
+#include "auxv.h"
+#include "fp.h"
+#include "vector.h"
+#include "config.h"
+#include "util/functions.h"
 #include "spike_interface/spike_utils.h"
 
+// segments are loaded in pieces of this size, so that pending interrupts are not held up
+// for the whole of a large segment
+#define ELF_LOAD_CHUNK (64 * 1024)
+
 typedef struct elf_info_t {
   spike_file_t *f;
   process *p;
@@ -17,7 +33,14 @@ typedef struct elf_info_t {
 // the implementation of allocater. allocates memory space for later segment loading
 //
 static void *elf_alloc_mb(elf_ctx *ctx, uint64 elf_pa, uint64 elf_va, uint64 size) {
-  // directly returns the virtual address as we are in the Bare mode in lab1_x
+  // in the Bare mode of lab1_x, a segment can only be placed at its own virtual address,
+  // which must lie in the user program region chosen by pmm_init() (kernel/pmm.c).
+  if (elf_va < g_mem_layout.user_start || elf_va > g_mem_layout.user_end ||
+      size > g_mem_layout.user_end - elf_va) {
+    sprint("segment [0x%lx, 0x%lx) is outside the user region [0x%lx, 0x%lx).\n", elf_va,
+           elf_va + size, g_mem_layout.user_start, g_mem_layout.user_end);
+    return NULL;
+  }
   return (void *)elf_va;
 }
 
@@ -66,25 +89,147 @@ elf_status elf_load(elf_ctx *ctx) {
 
     // allocate memory block before elf loading
     void *dest = elf_alloc_mb(ctx, ph_addr.vaddr, ph_addr.vaddr, ph_addr.memsz);
+    if (!dest) return EL_ENOMEM;
 
-    // actual loading
-    if (elf_fpread(ctx, dest, ph_addr.memsz, ph_addr.off) != ph_addr.memsz)
-      return EL_EIO;
+    // actual loading. the part of the segment beyond the file content (e.g., .bss) is zeroed.
+    // both go in ELF_LOAD_CHUNK pieces, with a preemption point after each.
+    for (uint64 done = 0; done < ph_addr.memsz; done += ELF_LOAD_CHUNK) {
+      uint64 n = MIN(ELF_LOAD_CHUNK, ph_addr.memsz - done);
+      uint64 from_file = done < ph_addr.filesz ? MIN(n, ph_addr.filesz - done) : 0;
+      if (from_file && elf_fpread(ctx, dest + done, from_file, ph_addr.off + done) != from_file)
+        return EL_EIO;
+      memset(dest + done + from_file, 0, n - from_file);
+      // preempt_point() is defined in kernel/strap.c
+      preempt_point();
+    }
+    trace("elf: segment %lx filesz %lx memsz %lx", ph_addr.vaddr, ph_addr.filesz, ph_addr.memsz);
   }
 
   return EL_OK;
 }
 
+// symbols are read from the file this many at a time
+#define SYM_BATCH 32
+
+static void sort_symbols(elf_symtab *tab) {
+  // shell sort: the tables are small, and mostly sorted already
+  for (int gap = tab->nsyms / 2; gap > 0; gap /= 2)
+    for (int i = gap; i < tab->nsyms; i++) {
+      elf_symbol tmp = tab->syms[i];
+      int j = i;
+      for (; j >= gap && tab->syms[j - gap].addr > tmp.addr; j -= gap)
+        tab->syms[j] = tab->syms[j - gap];
+      tab->syms[j] = tmp;
+    }
+}
+
+//
+// collect the code symbols (functions, and the untyped labels of assembly code) of the elf
+// into tab, sorted by address for elf_find_symbol(). returns EL_ERR if the elf is stripped,
+// and EL_ENOMEM if tab is full, in which case it holds the symbols collected so far.
+//
+elf_status elf_load_symbols(elf_ctx *ctx, elf_symtab *tab) {
+  static elf_sym batch[SYM_BATCH];
+  elf_sect_header symtab, strtab;
+  elf_status ret = EL_OK;
+  int i;
+  uint64 off;
+
+  tab->nsyms = 0;
+  tab->names_len = 0;
+
+  // find the symbol table, and the string table holding its names
+  for (i = 0, off = ctx->ehdr.shoff; i < ctx->ehdr.shnum; i++, off += sizeof(symtab)) {
+    if (elf_fpread(ctx, &symtab, sizeof(symtab), off) != sizeof(symtab)) return EL_EIO;
+    if (symtab.type == ELF_SHT_SYMTAB) break;
+  }
+  if (i == ctx->ehdr.shnum || symtab.link >= ctx->ehdr.shnum) return EL_ERR;
+  off = ctx->ehdr.shoff + symtab.link * sizeof(strtab);
+  if (elf_fpread(ctx, &strtab, sizeof(strtab), off) != sizeof(strtab)) return EL_EIO;
+
+  uint64 nsyms = symtab.size / sizeof(elf_sym);
+  for (uint64 first = 0; first < nsyms && ret == EL_OK; first += SYM_BATCH) {
+    uint64 n = MIN(nsyms - first, SYM_BATCH);
+    off = symtab.offset + first * sizeof(elf_sym);
+    if (elf_fpread(ctx, batch, n * sizeof(elf_sym), off) != n * sizeof(elf_sym)) return EL_EIO;
+
+    for (int j = 0; j < n; j++) {
+      elf_sym *sym = &batch[j];
+      int type = ELF_ST_TYPE(sym->info);
+      if ((type != ELF_STT_FUNC && type != ELF_STT_NOTYPE) || !sym->shndx || !sym->value ||
+          !sym->name)
+        continue;
+      if (tab->nsyms == tab->max_syms || tab->max_names - tab->names_len < 2) {
+        ret = EL_ENOMEM;
+        break;
+      }
+
+      // read the name in place, truncating it if it does not fit
+      char *name = tab->names + tab->names_len;
+      uint64 len = MIN(tab->max_names - tab->names_len, 64);
+      uint64 got = elf_fpread(ctx, name, len, strtab.offset + sym->name);
+      uint64 k = 0;
+      while (k < got && name[k]) k++;
+      // skip the mapping symbols ($x, $d) that only mark code and data
+      if (k == 0 || name[0] == '$') continue;
+      name[MIN(k, len - 1)] = 0;
+
+      tab->syms[tab->nsyms].addr = sym->value;
+      tab->syms[tab->nsyms].size = sym->size;
+      tab->syms[tab->nsyms].name = tab->names_len;
+      tab->nsyms++;
+      tab->names_len += MIN(k, len - 1) + 1;
+    }
+  }
+
+  sort_symbols(tab);
+  return ret;
+}
+
+//
+// find the symbol with the highest address not above addr. a symbol with a known size must
+// also cover addr.
+//
+int elf_find_symbol(const elf_symtab *tab, uint64 addr) {
+  int lo = 0, hi = tab->nsyms;  // the answer is below hi
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (tab->syms[mid].addr <= addr)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (lo == 0) return -1;
+
+  const elf_symbol *sym = &tab->syms[lo - 1];
+  if (sym->size && addr >= sym->addr + sym->size) return -1;
+  return lo - 1;
+}
+
 typedef union {
   uint64 buf[MAX_CMDLINE_ARGS];
   char *argv[MAX_CMDLINE_ARGS];
 } arg_buf;
 
+// a NAME=value string, with NAME made of letters, digits and '_', not starting with a digit
+static int is_env_assignment(const char *s) {
+  if (!(*s == '_' || (*s >= 'a' && *s <= 'z') || (*s >= 'A' && *s <= 'Z'))) return 0;
+  for (; *s && *s != '='; s++)
+    if (!(*s == '_' || (*s >= 'a' && *s <= 'z') || (*s >= 'A' && *s <= 'Z') ||
+          (*s >= '0' && *s <= '9')))
+      return 0;
+  return *s == '=';
+}
+
+//
+// returns the number of string(s) after PKE kernel (and the environment) in command line,
+// the application and its arguments, and store the string(s) in arg_bug_msg, ended by a
+// NULL. the path of the PKE kernel itself is returned in *kernel_path.
 //
-// returns the number (should be 1) of string(s) after PKE kernel in command line.
-// and store the string(s) in arg_bug_msg.
+// like env(1), NAME=value strings in front of the application go to its environment: they
+// are stored in envp, ended by a NULL.
 //
-static size_t parse_args(arg_buf *arg_bug_msg) {
+static size_t parse_args(arg_buf *arg_bug_msg, char **kernel_path, char *envp[]) {
   // HTIFSYS_getmainvars frontend call reads command arguments to (input) *arg_bug_msg
   long r = frontend_syscall(HTIFSYS_getmainvars, (uint64)arg_bug_msg,
       sizeof(*arg_bug_msg), 0, 0, 0, 0, 0);
@@ -92,10 +237,19 @@ static size_t parse_args(arg_buf *arg_bug_msg) {
 
   size_t pk_argc = arg_bug_msg->buf[0];
   uint64 *pk_argv = &arg_bug_msg->buf[1];
+  *kernel_path = (char *)(uintptr_t)pk_argv[0];
 
-  int arg = 1;  // skip the PKE OS kernel string, leave behind only the application name
-  for (size_t i = 0; arg + i < pk_argc; i++)
+  size_t arg = 1;  // skip the PKE OS kernel string
+  int envc = 0;
+  for (; arg < pk_argc && is_env_assignment((char *)(uintptr_t)pk_argv[arg]); arg++)
+    envp[envc++] = (char *)(uintptr_t)pk_argv[arg];
+  envp[envc] = 0;
+
+  // argv[i] overlaps pk_argv[i - 1], which has been read already
+  size_t i;
+  for (i = 0; arg + i < pk_argc; i++)
     arg_bug_msg->argv[i] = (char *)(uintptr_t)pk_argv[arg + i];
+  arg_bug_msg->argv[i] = 0;
 
   //returns the number of strings after PKE kernel in command line
   return pk_argc - arg;
@@ -106,12 +260,15 @@ static size_t parse_args(arg_buf *arg_bug_msg) {
 //
 void load_bincode_from_host_elf(process *p) {
   arg_buf arg_bug_msg;
+  char *kernel_path;
+  char *envp[MAX_CMDLINE_ARGS];
 
   // retrieve command line arguements
-  size_t argc = parse_args(&arg_bug_msg);
+  size_t argc = parse_args(&arg_bug_msg, &kernel_path, envp);
   if (!argc) panic("You need to specify the application program!\n");
 
   sprint("Application: %s\n", arg_bug_msg.argv[0]);
+  trace_begin("elf load");
 
   //elf loading. elf_ctx is defined in kernel/elf.h, used to track the loading process.
   elf_ctx elfloader;
@@ -122,19 +279,61 @@ void load_bincode_from_host_elf(process *p) {
   info.p = p;
   // IS_ERR_VALUE is a macro defined in spike_interface/spike_htif.h
   if (IS_ERR_VALUE(info.f)) panic("Fail on openning the input application program.\n");
+  boot_mark(BOOT_ELF_OPEN);
+  trace("elf opened");
 
   // init elfloader context. elf_init() is defined above.
   if (elf_init(&elfloader, &info) != EL_OK)
     panic("fail to init elfloader.\n");
+  boot_mark(BOOT_ELF_HEADER);
+  trace("elf header read");
 
   // load elf. elf_load() is defined above.
   if (elf_load(&elfloader) != EL_OK) panic("Fail on loading elf.\n");
+  boot_mark(BOOT_ELF_LOAD);
+  trace("elf segments loaded");
 
   // entry (virtual, also physical in lab1_x) address
   p->trapframe->epc = elfloader.ehdr.entry;
 
+  // the profiler symbolizes its samples with the symbols of both the application and the
+  // kernel. profile_load_symbols() is defined in kernel/profile.c
+  if (PROFILE_ENABLE) {
+    profile_load_symbols(PROFILE_USER, &elfloader);
+
+    elf_ctx kernel_elf;
+    elf_info kernel_info = {spike_file_open(kernel_path, O_RDONLY, 0), p};
+    if (!IS_ERR_VALUE(kernel_info.f)) {
+      if (elf_init(&kernel_elf, &kernel_info) == EL_OK)
+        profile_load_symbols(PROFILE_KERNEL, &kernel_elf);
+      spike_file_close(kernel_info.f);
+    }
+  }
+
   // close the host spike file
   spike_file_close( info.f );
+  boot_mark(BOOT_ELF_CLOSE);
+
+  // the FP and vector units, which the kernel hands to the process on its first use
+  uint64 hwcap = 0;
+  if (g_fp_available) hwcap |= 1 << ('F' - 'A') | 1 << ('D' - 'A');
+  if (g_vec_available) hwcap |= 1 << ('V' - 'A');
+
+  // lay out the arguments, the environment and the auxiliary vector on the user stack.
+  // ustack_init() is defined in kernel/ustack.c, and g_kinfo in kernel/kinfo.c
+  uint64 auxv[] = {
+      AT_PAGESZ, PGSIZE,
+      AT_ENTRY, p->trapframe->epc,
+      AT_HWCAP, hwcap,
+      AT_CLKTCK, TIMER_HZ,
+      AT_PKE_NHARTS, g_kinfo->nharts,
+      AT_PKE_CLOCK_FREQ, g_kinfo->clock_freq,
+      AT_PKE_TIMEBASE_FREQ, g_kinfo->timebase_freq,
+      AT_PKE_KINFO, (uint64)g_kinfo,
+      AT_NULL, 0,
+  };
+  ustack_init(p, arg_bug_msg.argv, envp, auxv);
+  trace_end("elf load");
 
   sprint("Application program entry point (virtual address): 0x%lx\n", p->trapframe->epc);
 }
@@ -37,8 +37,36 @@ typedef struct elf_prog_header_t {
   uint64 align;  /* Segment alignment */
 } elf_prog_header;
 
+// Section header.
+typedef struct elf_sect_header_t {
+  uint32 name;      /* Section name (string table index) */
+  uint32 type;      /* Section type */
+  uint64 flags;     /* Section flags */
+  uint64 addr;      /* Section virtual address at execution */
+  uint64 offset;    /* Section file offset */
+  uint64 size;      /* Section size in bytes */
+  uint32 link;      /* Link to another section */
+  uint32 info;      /* Additional section information */
+  uint64 addralign; /* Section alignment */
+  uint64 entsize;   /* Entry size if section holds table */
+} elf_sect_header;
+
+// Symbol table entry.
+typedef struct elf_sym_t {
+  uint32 name;  /* Symbol name (string table index) */
+  uint8 info;   /* Symbol type and binding */
+  uint8 other;  /* Symbol visibility */
+  uint16 shndx; /* Section index */
+  uint64 value; /* Symbol value */
+  uint64 size;  /* Symbol size */
+} elf_sym;
+
 #define ELF_MAGIC 0x464C457FU  // "\x7FELF" in little endian
 #define ELF_PROG_LOAD 1
+#define ELF_SHT_SYMTAB 2
+#define ELF_STT_NOTYPE 0
+#define ELF_STT_FUNC 2
+#define ELF_ST_TYPE(info) ((info)&0xf)
 
 typedef enum elf_status_t {
   EL_OK = 0,
@@ -55,8 +83,29 @@ typedef struct elf_ctx_t {
   elf_header ehdr;
 } elf_ctx;
 
+// code symbols of an ELF image, sorted by address. see elf_load_symbols().
+typedef struct elf_symbol_t {
+  uint64 addr;
+  uint64 size;
+  uint32 name;  // offset of the name in elf_symtab.names
+} elf_symbol;
+
+typedef struct elf_symtab_t {
+  // storage and capacities are provided by the caller
+  elf_symbol *syms;
+  int max_syms;
+  char *names;
+  uint32 max_names;
+  // filled by elf_load_symbols()
+  int nsyms;
+  uint32 names_len;
+} elf_symtab;
+
 elf_status elf_init(elf_ctx *ctx, void *info);
 elf_status elf_load(elf_ctx *ctx);
+elf_status elf_load_symbols(elf_ctx *ctx, elf_symtab *tab);
+// index of the symbol covering addr in tab, -1 if none
+int elf_find_symbol(const elf_symtab *tab, uint64 addr);
 
 void load_bincode_from_host_elf(process *p);
 
@@ -0,0 +1,104 @@
+/*
+ * lazy floating-point context switching. the FP registers belong to one process at a time,
+ * fp_owner, and are left in place when other processes run, with sstatus.FS turned Off
+ * for them. a process that then uses FP takes an illegal-instruction trap, and only then
+ * are the registers of the owner saved (if it changed them, i.e., FS was Dirty) and its
+ * own restored. processes that never touch FP never pay for it.
+ */
+
+#include "fp.h"
+#include "riscv.h"
+#include "config.h"
+#include "process.h"
+#include "trace.h"
+
+#include "spike_interface/spike_utils.h"
+
+// the process whose FP state is in the registers, if any
+static process *fp_owner;
+
+static struct {
+  uint64 traps, saves, restores;
+} fp_stats;
+
+// set by m_start(), which can read misa, if the hart has the F and D extensions
+int g_fp_available = 0;
+
+static void set_fs(uint64 fs) { write_csr(sstatus, (read_csr(sstatus) & ~SSTATUS_FS) | fs); }
+
+#define FP_REGS(X)                                                                      \
+  X(0) X(1) X(2) X(3) X(4) X(5) X(6) X(7) X(8) X(9) X(10) X(11) X(12) X(13) X(14) X(15) \
+  X(16) X(17) X(18) X(19) X(20) X(21) X(22) X(23) X(24) X(25) X(26) X(27) X(28) X(29)  \
+  X(30) X(31)
+
+// FP instructions in S-mode need FS to be on as well
+static void fp_save(process *p) {
+  set_fs(SSTATUS_FS_CLEAN);
+#define X(n) asm volatile("fsd f" #n ", %0" : "=m"(p->fp.f[n]));
+  FP_REGS(X)
+#undef X
+  asm volatile("frcsr %0" : "=r"(p->fp.fcsr));
+  p->fp_dirty = 0;
+  fp_stats.saves++;
+}
+
+static void fp_restore(process *p) {
+  set_fs(SSTATUS_FS_CLEAN);
+#define X(n) asm volatile("fld f" #n ", %0" : : "m"(p->fp.f[n]));
+  FP_REGS(X)
+#undef X
+  asm volatile("fscsr %0" : : "r"(p->fp.fcsr));
+  fp_stats.restores++;
+}
+
+// make the registers hold the FP state of p, saving those of the owner first if needed
+static void fp_take(process *p) {
+  if (fp_owner && fp_owner->fp_dirty) fp_save(fp_owner);
+  // a process starts with all FP registers and fcsr zeroed, which is what p->fp holds
+  // until the first save
+  fp_restore(p);
+  fp_owner = p;
+  p->fp_used = 1;
+}
+
+//
+// called by switch_to() when next is about to run instead of prev (NULL at first).
+//
+void fp_switch(process *prev, process *next) {
+  if (!g_fp_available) return;
+
+  // the registers stay with their owner, remember whether the owner changed them
+  if (prev && prev == fp_owner && (read_csr(sstatus) & SSTATUS_FS) == SSTATUS_FS_DIRTY)
+    prev->fp_dirty = 1;
+
+  if (next == fp_owner)
+    set_fs(next->fp_dirty ? SSTATUS_FS_DIRTY : SSTATUS_FS_CLEAN);
+  else if (FP_EAGER_RESTORE && next->fp_used)
+    fp_take(next);
+  else
+    set_fs(SSTATUS_FS_OFF);
+}
+
+//
+// an illegal-instruction trap of p. with FS Off, it is probably p using FP for the first
+// time since it was switched in: give it the FP registers, and have it retry the
+// instruction. returns 0 if the instruction is illegal after all.
+//
+int fp_handle_trap(process *p) {
+  if (!g_fp_available || (read_csr(sstatus) & SSTATUS_FS) != SSTATUS_FS_OFF) return 0;
+
+  trace("fp: trap of pid %d, owner pid %d", p->pid, fp_owner ? fp_owner->pid : 0);
+  fp_stats.traps++;
+  fp_take(p);
+  return 1;
+}
+
+static void fp_report(int code, int panic) {
+  sprint("FP context: %ld traps, %ld saves, %ld restores\n", fp_stats.traps, fp_stats.saves,
+         fp_stats.restores);
+}
+
+void fp_init(void) {
+  set_fs(SSTATUS_FS_OFF);
+  if (g_fp_available) register_shutdown_hook(fp_report);
+}
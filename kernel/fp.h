@@ -0,0 +1,19 @@
+#ifndef _FP_H_
+#define _FP_H_
+
+#include "util/types.h"
+
+// floating-point registers of a process, saved while another process owns the FP unit
+typedef struct fp_context_t {
+  uint64 f[32];
+  uint64 fcsr;
+} fp_context;
+
+extern int g_fp_available;
+
+struct process_t;
+void fp_init(void);
+void fp_switch(struct process_t *prev, struct process_t *next);
+int fp_handle_trap(struct process_t *p);
+
+#endif
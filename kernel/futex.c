@@ -0,0 +1,124 @@
+/*
+ * futexes: the slow path of user-level locks. a user thread finds a lock busy with AMOs on
+ * a word of its memory, and asks the kernel to sleep only then, with futex_wait(), giving
+ * the value it saw. the kernel rechecks the word and queues the thread in a hash table
+ * keyed by the physical address of the word, where futex_wake() finds it.
+ *
+ * in lab1 there is no other process to run, or to call futex_wake(), while one sleeps:
+ * the sleeper waits for its timeout with wfi, and a wait without a timeout fails at once
+ * rather than hang the machine.
+ */
+
+#include "futex.h"
+#include "riscv.h"
+#include "pmm.h"
+#include "process.h"
+#include "strap.h"
+#include "timer.h"
+#include "trace.h"
+
+#include "spike_interface/spike_utils.h"
+
+// a process sleeping on a futex, linked in the bucket of its word
+typedef struct futex_waiter_t {
+  process *p;
+  uint64 pa;
+  volatile int woken;
+  struct futex_waiter_t *next;
+} futex_waiter;
+
+// the buckets are changed by syscalls only, never by interrupt handlers
+static futex_waiter *futex_table[FUTEX_HASH_SIZE];
+
+static struct {
+  uint64 waits, mismatches, timeouts, wakes, woken;
+} futex_stats;
+
+// the physical address of a user word, or 0 if it is not one. user virtual addresses are
+// physical in lab1.
+static uint64 futex_pa(uint64 uaddr) {
+  if (uaddr % sizeof(uint32) != 0 || uaddr < g_mem_layout.user_start ||
+      uaddr + sizeof(uint32) > g_mem_layout.user_stack_top)
+    return 0;
+  return uaddr;
+}
+
+static futex_waiter **futex_bucket(uint64 pa) {
+  return &futex_table[(pa >> 2) & (FUTEX_HASH_SIZE - 1)];
+}
+
+static void futex_unqueue(futex_waiter *w) {
+  for (futex_waiter **pw = futex_bucket(w->pa); *pw; pw = &(*pw)->next)
+    if (*pw == w) {
+      *pw = w->next;
+      return;
+    }
+}
+
+static void futex_timeout(ktimer *t) { *(volatile int *)t->arg = 1; }
+
+long futex_wait(process *p, uint64 uaddr, uint32 expected, uint64 timeout) {
+  uint64 pa = futex_pa(uaddr);
+  if (!pa) return -1;
+
+  // the lock may have been released since the user saw it busy
+  if (*(volatile uint32 *)pa != expected) {
+    futex_stats.mismatches++;
+    return -1;
+  }
+  // nobody could ever wake us
+  if (!timeout) return -1;
+
+  futex_stats.waits++;
+  // see wait_tick() in kernel/strap.c
+  int intr = intr_save();
+  futex_waiter w = {p, pa, 0, 0};
+  futex_waiter **b = futex_bucket(pa);
+  w.next = *b;
+  *b = &w;
+
+  volatile int timed_out = 0;
+  ktimer t = {.fn = futex_timeout, .arg = (void *)&timed_out};
+  timer_add(&t, timer_now() + timeout);
+
+  trace_begin("futex wait %lx", uaddr);
+  while (!w.woken && !timed_out) wait_tick();
+  trace_end("futex wait");
+
+  timer_cancel(&t);
+  if (!w.woken) {
+    futex_unqueue(&w);
+    futex_stats.timeouts++;
+  }
+  intr_restore(intr);
+  return w.woken ? 0 : -1;
+}
+
+long futex_wake(uint64 uaddr, int n) {
+  uint64 pa = futex_pa(uaddr);
+  if (!pa) return -1;
+
+  futex_stats.wakes++;
+  int woken = 0;
+  for (futex_waiter **pw = futex_bucket(pa); *pw && woken < n;) {
+    futex_waiter *w = *pw;
+    if (w->pa != pa) {
+      pw = &w->next;
+      continue;
+    }
+    *pw = w->next;
+    w->woken = 1;
+    woken++;
+  }
+  futex_stats.woken += woken;
+  return woken;
+}
+
+static void futex_report(int code, int panic) {
+  if (!futex_stats.waits && !futex_stats.mismatches && !futex_stats.wakes) return;
+  sprint("futex: %ld waits (%ld timed out), %ld value mismatches, %ld wakes (%ld woken)\n",
+         futex_stats.waits, futex_stats.timeouts, futex_stats.mismatches, futex_stats.wakes,
+         futex_stats.woken);
+}
+
+void futex_init(void) { register_shutdown_hook(futex_report); }
@@ -0,0 +1,17 @@
+#ifndef _FUTEX_H_
+#define _FUTEX_H_
+
+#include "util/types.h"
+
+// number of buckets of the futex wait-queue table, must be a power of 2
+#define FUTEX_HASH_SIZE 64
+
+struct process_t;
+// sleep while the 32-bit word at uaddr holds expected, until futex_wake() on the same word
+// or timeout ticks pass (0: no timeout). returns 0 when woken, -1 otherwise.
+long futex_wait(struct process_t *p, uint64 uaddr, uint32 expected, uint64 timeout);
+// wake up to n processes sleeping on the word at uaddr, returns how many were woken
+long futex_wake(uint64 uaddr, int n);
+void futex_init(void);
+
+#endif
@@ -0,0 +1,83 @@
+/*
+ * hardware performance counters for user programs. a process picks an event for a counter
+ * with hpm_open(), and then reads the counter directly (rdhpmcounter is allowed in U-mode,
+ * see hpm_init()), without entering the kernel. the counters are virtualized: each process
+ * sees only the events counted while it was running.
+ */
+
+#include "hpm.h"
+#include "riscv.h"
+#include "process.h"
+#include "mcall.h"
+
+#include "spike_interface/spike_utils.h"
+
+static uint64 read_hpmcounter(int counter) {
+  switch (counter) {
+#define X(n) case n: return read_csr(hpmcounter##n);
+    HPM_COUNTERS(X)
+#undef X
+  }
+  return 0;
+}
+
+static int valid_counter(int counter) {
+  return counter >= HPM_FIRST && counter < HPM_FIRST + HPM_NCOUNTERS &&
+         (g_hpm_mask & (1 << counter));
+}
+
+//
+// let user programs read cycle, time, instret, and the implemented event counters.
+// m_start() has granted the same to S-mode in mcounteren.
+//
+void hpm_init(void) {
+  write_csr(scounteren, COUNTEREN_CY | COUNTEREN_TM | COUNTEREN_IR | g_hpm_mask);
+
+  int n = 0;
+  for (int i = HPM_FIRST; i < HPM_FIRST + HPM_NCOUNTERS; i++) n += valid_counter(i);
+  sprint("Performance counters: cycle, time, instret, and %d event counter(s).\n", n);
+}
+
+//
+// count event (implementation defined, written to mhpmevent) for p, from zero. returns the
+// number of the counter to read, or -1 if no counter is free.
+//
+int hpm_open(process *p, uint64 event) {
+  if (!event) return -1;
+  for (int n = HPM_FIRST; n < HPM_FIRST + HPM_NCOUNTERS; n++) {
+    if (!valid_counter(n) || p->hpm_event[n - HPM_FIRST]) continue;
+    p->hpm_event[n - HPM_FIRST] = event;
+    p->hpm_count[n - HPM_FIRST] = 0;
+    // mcall() is defined in kernel/mcall.h
+    if (p == current) mcall(MCALL_HPM_SET, n, event, 0);
+    return n;
+  }
+  return -1;
+}
+
+int hpm_close(process *p, int counter) {
+  if (!valid_counter(counter) || !p->hpm_event[counter - HPM_FIRST]) return -1;
+  p->hpm_event[counter - HPM_FIRST] = 0;
+  if (p == current) mcall(MCALL_HPM_SET, counter, 0, 0);
+  return 0;
+}
+
+int hpm_read(process *p, int counter, uint64 *value) {
+  if (!valid_counter(counter) || !p->hpm_event[counter - HPM_FIRST]) return -1;
+  *value = p == current ? read_hpmcounter(counter) : p->hpm_count[counter - HPM_FIRST];
+  return 0;
+}
+
+//
+// save the counts of prev, and load the events and counts of next. called on a context
+// switch, prev is NULL for the first one.
+//
+void hpm_switch(process *prev, process *next) {
+  for (int n = HPM_FIRST; n < HPM_FIRST + HPM_NCOUNTERS; n++) {
+    if (!valid_counter(n)) continue;
+    int i = n - HPM_FIRST;
+    if (prev && prev->hpm_event[i]) prev->hpm_count[i] = read_hpmcounter(n);
+    if ((prev && prev->hpm_event[i]) || next->hpm_event[i])
+      mcall(MCALL_HPM_SET, n, next->hpm_event[i], next->hpm_count[i]);
+  }
+}
@@ -0,0 +1,28 @@
+#ifndef _HPM_H_
+#define _HPM_H_
+
+#include "util/types.h"
+
+// PKE manages the hardware performance monitor counters HPM_FIRST .. HPM_FIRST +
+// HPM_NCOUNTERS - 1, i.e., mhpmcounter3 .. mhpmcounter10, those that are implemented.
+#define HPM_FIRST 3
+#define HPM_NCOUNTERS 8
+// X(n) for every counter number n, to name the CSRs, which can not be indexed at run time
+#define HPM_COUNTERS(X) X(3) X(4) X(5) X(6) X(7) X(8) X(9) X(10)
+
+// bit n is set if mhpmcounter<n> is implemented, found by hpm_probe() at boot
+extern uint32 g_hpm_mask;
+
+// M-mode side, defined in kernel/machine/mhpm.c
+void hpm_probe(void);
+void mhpm_set(int counter, uint64 event, uint64 value);
+
+// S-mode side, defined in kernel/hpm.c
+struct process_t;
+void hpm_init(void);
+int hpm_open(struct process_t *p, uint64 event);
+int hpm_close(struct process_t *p, int counter);
+int hpm_read(struct process_t *p, int counter, uint64 *value);
+void hpm_switch(struct process_t *prev, struct process_t *next);
+
+#endif
@@ -0,0 +1,52 @@
+/*
+ * the idle path: when the kernel has nothing to do until an interrupt, e.g., a process
+ * sleeps on a timer, the hart stops in wfi instead of polling. an emulator like spike then
+ * runs no instructions for it at all. the timer is armed only for the next kernel timer
+ * (kernel/timer.c), so an idle hart is not woken by ticks it does not need.
+ *
+ * idle time is accounted per hart in mtime units, as the cycle counter of spike does not
+ * advance in wfi.
+ */
+
+#include "idle.h"
+#include "riscv.h"
+#include "config.h"
+#include "timer.h"
+#include "trace.h"
+
+#include "spike_interface/spike_utils.h"
+
+static struct {
+  uint64 time;   // in wfi, in mtime units
+  uint64 waits;  // idle_wait() calls
+  uint64 wfis;   // wfi executed, more than waits if woken for nothing
+} idle_stats[NCPU];
+
+void idle_wait(void) {
+  uint64 hart = read_tp();
+  uint64 start = read_csr(time);
+
+  trace_begin("idle");
+  // the kernel runs with sstatus.SIE clear: wfi returns with the interrupt pending, to be
+  // handled by the caller
+  while (!(read_csr(sip) & read_csr(sie))) {
+    asm volatile("wfi");
+    idle_stats[hart].wfis++;
+  }
+  trace_end("idle");
+
+  idle_stats[hart].time += read_csr(time) - start;
+  idle_stats[hart].waits++;
+}
+
+static void idle_report(int code, int panic) {
+  uint64 total = read_csr(time) - g_timer_base;
+  for (int hart = 0; hart < NCPU; hart++) {
+    if (!idle_stats[hart].waits) continue;
+    sprint("hart %d: idle %ld%% (%ld of %ld mtime units), %ld waits, %ld wfi\n", hart,
+           total ? idle_stats[hart].time * 100 / total : 0, idle_stats[hart].time, total,
+           idle_stats[hart].waits, idle_stats[hart].wfis);
+  }
+}
+
+void idle_init(void) { register_shutdown_hook(idle_report); }
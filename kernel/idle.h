@@ -0,0 +1,11 @@
+#ifndef _IDLE_H_
+#define _IDLE_H_
+
+#include "util/types.h"
+
+// wait with wfi until an enabled interrupt is pending, and count the time as idle
+void idle_wait(void);
+// report the idle time of the harts at shutdown
+void idle_init(void);
+
+#endif
@@ -3,9 +3,26 @@
  */
 
 #include "riscv.h"
+#include "config.h"
 #include "string.h"
 #include "elf.h"
 #include "process.h"
+#include "pmm.h"
+#include "trace.h"
+#include "profile.h"
+#include "hpm.h"
+#include "boot.h"
+#include "fp.h"
+#include "vector.h"
+#include "futex.h"
+#include "pipe.h"
+#include "timer.h"
+#include "idle.h"
+#include "strap.h"
+#include "kinfo.h"
+#include "plic.h"
+#include "console.h"
+#include "kmem_bench.h"
 
 #include "spike_interface/spike_utils.h"
 
@@ -17,14 +34,18 @@ process user_app;
 // load_bincode_from_host_elf is defined in elf.c
 //
 void load_user_program(process *proc) {
-  // USER_TRAP_FRAME is a physical address defined in kernel/config.h
-  proc->trapframe = (trapframe *)USER_TRAP_FRAME;
+  // the trapframe takes a page from the kernel free pages. alloc_page() is defined in
+  // kernel/pmm.c
+  proc->trapframe = (trapframe *)alloc_page();
+  if (!proc->trapframe) panic("no free page for the trapframe.\n");
   memset(proc->trapframe, 0, sizeof(trapframe));
-  // USER_KSTACK is also a physical address defined in kernel/config.h
-  proc->kstack = USER_KSTACK;
-  proc->trapframe->regs.sp = USER_STACK;
+  // the kernel stack, above its guard, is laid out by pmm_init()
+  proc->kstack = g_mem_layout.kstack_top;
+  // the only process of lab1
+  proc->pid = 1;
 
-  // load_bincode_from_host_elf() is defined in kernel/elf.c
+  // load_bincode_from_host_elf() is defined in kernel/elf.c. it also sets up the user stack,
+  // which starts from the top of the emulated memory (see pmm_init()), and grows on demand.
   load_bincode_from_host_elf(proc);
 }
 
@@ -32,6 +53,7 @@ void load_user_program(process *proc) {
 // s_start: S-mode entry point of riscv-pke OS kernel.
 //
 int s_start(void) {
+  boot_mark(BOOT_SSTART);
   sprint("Enter supervisor mode...\n");
   // Note: we use direct (i.e., Bare mode) for memory mapping in lab1.
   // which means: Virtual Address = Physical Address
@@ -40,6 +62,57 @@ int s_start(void) {
   // write_csr is a macro defined in kernel/riscv.h
   write_csr(satp, 0);
 
+  // traps taken while the kernel runs, i.e., the interrupts it lets in, enter
+  // smode_kernel_vector, defined in kernel/strap_vector.S
+  write_csr(stvec, (uint64)smode_kernel_vector);
+
+  // decide the memory layout from the memory size found in the DTB.
+  // pmm_init() is defined in kernel/pmm.c
+  pmm_init();
+
+  // have the trace rings printed should we panic. trace_init() is defined in kernel/trace.c
+  trace_init();
+
+  // start sampling for the profiler, if configured. profile_init() is defined in
+  // kernel/profile.c
+  profile_init();
+
+  // let user programs read the performance counters. hpm_init() is defined in kernel/hpm.c
+  hpm_init();
+
+  // switch the FP registers between processes lazily. fp_init() is defined in kernel/fp.c
+  fp_init();
+  // the same for the vector registers. vec_init() is defined in kernel/vector.c
+  vec_init();
+
+  // report the futex statistics at shutdown. futex_init() is defined in kernel/futex.c
+  futex_init();
+  // and those of the pipes. pipe_init() is defined in kernel/pipe.c
+  pipe_init();
+
+  // the page of facts the applications read without syscalls. kinfo_init() is defined in
+  // kernel/kinfo.c
+  kinfo_init();
+
+  // start the timing wheel of kernel timers. timer_init() is defined in kernel/timer.c
+  timer_init();
+  // account the time the hart waits in wfi. idle_init() is defined in kernel/idle.c
+  idle_init();
+
+  // route the device interrupts to this hart, and put the console of the user on the UART
+  // if there is one. plic_init() and console_init() are defined in kernel/plic.c and
+  // kernel/console.c
+  plic_init();
+  console_init();
+
+  // take the timer ticks, which M-mode forwards as software interrupts (see
+  // kernel/machine/mtrap.c). they arrive once we are back in user mode.
+  write_csr(sie, read_csr(sie) | SIE_SSIE);
+
+  // time the string routines of the kernel, in a kernel built for it. kmem_bench() is
+  // defined in kernel/kmem_bench.c
+  if (KMEM_BENCH) kmem_bench();
+
   // the application code (elf) is first loaded into memory, and then put into execution
   load_user_program(&user_app);
 
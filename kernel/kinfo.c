@@ -0,0 +1,67 @@
+/*
+ * the kernel info page, shared with the applications. see kernel/kinfo.h.
+ *
+ * lab1 has no page tables, so the page can not be mapped read-only for the user: PMP
+ * entries apply to the kernel as well, which writes it. the applications only read it,
+ * through the user library.
+ */
+
+#include "kinfo.h"
+#include "riscv.h"
+#include "config.h"
+#include "pmm.h"
+#include "timer.h"
+#include "process.h"
+#include "util/functions.h"
+#include "util/string.h"
+
+#include "spike_interface/spike_utils.h"
+
+kinfo *g_kinfo;
+kstats g_kstats;
+
+#define NSEC_PER_SEC 1000000000UL
+#define KINFO_NS_SHIFT 32
+
+void kinfo_init(void) {
+  // the page is one of the kernel free pages, which the user can read in lab1 (bare mode)
+  g_kinfo = (kinfo *)alloc_page();
+  if (!g_kinfo) panic("no free page for the kernel info page.\n");
+  memset(g_kinfo, 0, PGSIZE);
+
+  g_kinfo->version = KINFO_VERSION;
+  g_kinfo->page_size = PGSIZE;
+  g_kinfo->nharts = g_platform.nharts ? MIN(g_platform.nharts, NCPU) : 1;
+  g_kinfo->clock_freq = g_platform.harts[0].clock_freq;
+  // the one timerinit() settled on, when the DTB has none
+  g_kinfo->timebase_freq = g_timer_interval * TIMER_HZ;
+  g_kinfo->tick_hz = TIMER_HZ;
+
+  // a 32.32 fixed point multiplier keeps the error below 1ns a second for timebase
+  // frequencies up to 4 GHz
+  g_kinfo->time_base = g_timer_base;
+  g_kinfo->ns_mult = (NSEC_PER_SEC << KINFO_NS_SHIFT) / g_kinfo->timebase_freq;
+  g_kinfo->ns_shift = KINFO_NS_SHIFT;
+}
+
+//
+// the writer side of the seqlock. the only writer is the hart about to return to the user,
+// with interrupts off (lab1 runs one hart). the odd seq is stored before the fields, and
+// the even one after them.
+//
+void kinfo_update(process *p) {
+  kinfo *k = g_kinfo;
+  uint64 seq = k->seq;
+
+  __atomic_store_n(&k->seq, seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  k->ticks = timer_now();
+  k->pid = p->pid;
+  k->hart = read_tp();
+  k->stats = g_kstats;
+  k->free_pages = free_page_count();
+  k->stack_bytes = p->stack_top - p->stack_bottom;
+
+  __atomic_store_n(&k->seq, seq + 2, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,72 @@
+#ifndef _KINFO_H_
+#define _KINFO_H_
+
+#include "util/types.h"
+
+#define KINFO_VERSION 2
+
+// counters of the kernel, published on the kinfo page
+typedef struct kstats_t {
+  uint64 traps;       // from the user, of any cause
+  uint64 syscalls;
+  uint64 timer_irqs;  // timer interrupts taken by the S-mode kernel
+  uint64 switches;    // switches to another process
+} kstats;
+
+//
+// the kernel info page: facts about the machine and the kernel, which applications read
+// directly instead of asking with a syscall, like the vDSO data of Linux. its address is
+// passed in the auxiliary vector as AT_PKE_KINFO (see kernel/auxv.h).
+//
+// the fields from seq on change as the system runs. the kernel updates them under the
+// seqlock seq, which is odd while an update is under way: a reader copies what it needs
+// between kinfo_read_begin() and kinfo_read_retry(), and starts over if the latter fails.
+//
+typedef struct kinfo_t {
+  uint64 version;        // KINFO_VERSION
+  uint64 page_size;
+  uint64 nharts;         // harts the kernel runs on
+  uint64 clock_freq;     // Hz of the cycle counter, 0 if the DTB does not tell
+  uint64 timebase_freq;  // Hz of the time counter
+  uint64 tick_hz;        // kernel timer ticks per second
+
+  uint64 seq;
+  // nanoseconds since boot = (time - time_base) * ns_mult >> ns_shift, where time is the
+  // time counter (rdtime), in a 128-bit product. from the DTB timebase-frequency.
+  uint64 time_base;
+  uint64 ns_mult;
+  uint64 ns_shift;
+  // timer ticks since boot, as last seen by the kernel
+  uint64 ticks;
+  // the process running, and the hart it runs on
+  uint64 pid;
+  uint64 hart;
+  kstats stats;
+  uint64 free_pages;   // kernel free pages, see kernel/pmm.c
+  uint64 stack_bytes;  // the user stack of the running process, as grown so far
+} kinfo;
+
+static inline uint64 kinfo_read_begin(const kinfo *k) {
+  uint64 seq;
+  // wait out an update in progress
+  while ((seq = __atomic_load_n(&k->seq, __ATOMIC_ACQUIRE)) & 1) continue;
+  return seq;
+}
+
+// 1 if the fields read since kinfo_read_begin() returned seq may be inconsistent
+static inline int kinfo_read_retry(const kinfo *k, uint64 seq) {
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  return __atomic_load_n(&k->seq, __ATOMIC_RELAXED) != seq;
+}
+
+// g_kinfo is set up by kinfo_init()
+extern kinfo *g_kinfo;
+// counted by the trap handlers, and published by kinfo_update()
+extern kstats g_kstats;
+
+void kinfo_init(void);
+// publish the state of the kernel as p is about to run. called with interrupts off.
+struct process_t;
+void kinfo_update(struct process_t *p);
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * a boot-time benchmark of the string routines the kernel runs (util/string.c): memcpy,
+ * memset, an overlapping memmove and strlen, in their scalar versions and, if the hart has
+ * V, in their vector ones. the user can not run the vector versions, which only the kernel
+ * turns on, so they are measured here, before the user program is loaded: the buffers are
+ * the user program region, unused until then. the results are printed as "BENCH {json}"
+ * lines, like those of the benchmark apps (user/bench/bench.c).
+ *
+ * only a kernel built with KMEM_BENCH (kernel/config.h) runs it. "make bench" builds one
+ * of its own, and runs it on spike with V.
+ */
+
+#include "kmem_bench.h"
+#include "riscv.h"
+#include "pmm.h"
+#include "util/string.h"
+
+#include "spike_interface/spike_utils.h"
+
+#define KMEM_MIN_LEN 16
+#define KMEM_MAX_LEN 16384
+
+enum { KMEM_MEMCPY, KMEM_MEMSET, KMEM_MEMMOVE, KMEM_STRLEN, KMEM_NOPS };
+
+static const char *kmem_names[KMEM_NOPS] = {"memcpy", "memset", "memmove_overlap", "strlen"};
+
+// run op iters times on len bytes. src holds len non-zero bytes and a NUL.
+static void kmem_run(int op, char *dst, char *src, uint64 len, uint64 iters) {
+  for (uint64 i = 0; i < iters; i++) {
+    switch (op) {
+      case KMEM_MEMCPY:
+        memcpy(dst, src, len);
+        break;
+      case KMEM_MEMSET:
+        memset(dst, i, len);
+        break;
+      case KMEM_MEMMOVE:
+        // dst above src: the backward copy
+        memmove(dst + 8, dst, len);
+        break;
+      case KMEM_STRLEN:
+        if (strlen(src) != len) panic("kmem_bench: strlen of %ld bytes is wrong.\n", len);
+        break;
+    }
+  }
+}
+
+static void kmem_measure(const char *version) {
+  char *src = (char *)g_mem_layout.user_start;
+  char *dst = src + KMEM_MAX_LEN + PGSIZE;
+
+  for (uint64 len = KMEM_MIN_LEN; len <= KMEM_MAX_LEN; len *= 4) {
+    // keep the total work about the same for all sizes
+    uint64 iters = KMEM_MAX_LEN * 4 / len;
+    memset(src, 0x5a, len);
+    src[len] = 0;
+    for (int op = 0; op < KMEM_NOPS; op++) {
+      kmem_run(op, dst, src, len, 1);
+      uint64 c0 = read_cycle(), i0 = read_csr(instret);
+      kmem_run(op, dst, src, len, iters);
+      uint64 c1 = read_cycle(), i1 = read_csr(instret);
+      sprint("BENCH {\"name\": \"kernel_%s_%s\", \"param\": %ld, \"iters\": %ld, "
+             "\"cycles\": %ld, \"instret\": %ld, \"cycles_per_iter\": %ld}\n",
+             kmem_names[op], version, len, iters, c1 - c0, i1 - i0, (c1 - c0) / iters);
+    }
+  }
+}
+
+void kmem_bench(void) {
+  if (g_mem_layout.user_end - g_mem_layout.user_start < 2 * (KMEM_MAX_LEN + PGSIZE))
+    panic("kmem_bench: the user program region is too small.\n");
+
+  // string_vector_enabled() and friends are defined in util/string.c
+  int vec = string_vector_enabled();
+  string_disable_vector();
+  kmem_measure("scalar");
+  if (vec) {
+    string_enable_vector();
+    kmem_measure("rvv");
+  }
+}
@@ -0,0 +1,7 @@
+#ifndef _KMEM_BENCH_H_
+#define _KMEM_BENCH_H_
+
+// time the string routines of the kernel, when built with KMEM_BENCH (see kernel/config.h)
+void kmem_bench(void);
+
+#endif
@@ -0,0 +1,43 @@
+/*
+ * Machine-mode side of the hardware performance counters: finding the implemented
+ * counters at boot, and programming them on behalf of the S-mode kernel (kernel/hpm.c).
+ */
+
+#include "kernel/riscv.h"
+#include "kernel/hpm.h"
+
+uint32 g_hpm_mask = 0;
+
+static uint64 read_mhpmcounter(int counter) {
+  switch (counter) {
+#define X(n) case n: return read_csr(mhpmcounter##n);
+    HPM_COUNTERS(X)
+#undef X
+  }
+  return 0;
+}
+
+void mhpm_set(int counter, uint64 event, uint64 value) {
+  switch (counter) {
+#define X(n)                           \
+  case n:                              \
+    write_csr(mhpmevent##n, event);    \
+    write_csr(mhpmcounter##n, value);  \
+    break;
+    HPM_COUNTERS(X)
+#undef X
+  }
+}
+
+//
+// an unimplemented counter is hardwired to zero, so it does not keep what we write to it.
+// the implemented ones are made readable by S-mode, which passes them on to the user.
+//
+void hpm_probe(void) {
+  for (int n = HPM_FIRST; n < HPM_FIRST + HPM_NCOUNTERS; n++) {
+    mhpm_set(n, 0, 1);
+    if (read_mhpmcounter(n)) g_hpm_mask |= 1 << n;
+    mhpm_set(n, 0, 0);
+  }
+  write_csr(mcounteren, read_csr(mcounteren) | g_hpm_mask);
+}
@@ -5,6 +5,11 @@
 #include "util/types.h"
 #include "kernel/riscv.h"
 #include "kernel/config.h"
+#include "util/string.h"
+#include "kernel/hpm.h"
+#include "kernel/boot.h"
+#include "kernel/fp.h"
+#include "kernel/vector.h"
 #include "spike_interface/spike_utils.h"
 
 //
@@ -17,30 +22,50 @@
 //
 __attribute__((aligned(16))) char stack0[4096 * NCPU];
 
+// stack0 stays the stack of s_start() and of the S-mode kernel after mret. M-mode traps,
+// which may interrupt it, run on a stack of their own: 4KB per hart of mstack (see
+// kernel/machine/mtrap_vector.S).
+__attribute__((aligned(16))) char mstack[4096 * NCPU];
+
+// g_itrframe is the frame where M-mode traps save the registers of the interrupted code.
+riscv_regs g_itrframe[NCPU];
+
 // sstart() is the supervisor state entry point defined in kernel/kernel.c
 extern void s_start();
+// M-mode trap entry point, defined in kernel/machine/mtrap_vector.S
+extern void mtrapvec();
+// timerinit() is defined in kernel/machine/mtrap.c
+extern void timerinit(uintptr_t hartid);
 
 // htif is defined in spike_interface/spike_htif.c, marks the availability of HTIF
 extern uint64 htif;
-// g_mem_size is defined in spike_interface/spike_memory.c, size of the emulated memory
+// g_mem_size is defined in spike_interface/spike_platform.c, size of the emulated memory
 extern uint64 g_mem_size;
 
 //
-// get the information of HTIF (calling interface) and the emulated memory by
-// parsing the Device Tree Blog (DTB, actually DTS) stored in memory.
+// get the information of HTIF (calling interface), the emulated memory and the other
+// platform devices by parsing the Device Tree Blog (DTB, actually DTS) stored in memory.
 //
 // the role of DTB is similar to that of Device Address Resolution Table (DART)
 // in Intel series CPUs. it records the details of devices and memory of the
 // platform simulated using Spike.
 //
 void init_dtb(uint64 dtb) {
-  // defined in spike_interface/spike_htif.c, enabling Host-Target InterFace (HTIF)
-  query_htif(dtb);
-  if (htif) sprint("HTIF is available!\r\n");
+  // defined in spike_interface/spike_platform.c. scans the DTB once, and caches what it
+  // finds in g_platform for the subsystems initialized later.
+  query_platform(dtb);
 
-  // defined in spike_interface/spike_memory.c, obtain information about emulated memory
-  query_mem(dtb);
+  if (htif) sprint("HTIF is available!\r\n");
   sprint("(Emulated) memory size: %ld MB\n", g_mem_size >> 20);
+  for (int i = 0; i < g_platform.nharts; i++)
+    sprint("Hart %ld: %s\n", g_platform.harts[i].hartid,
+           g_platform.harts[i].isa ? g_platform.harts[i].isa : "(unknown isa)");
+  if (g_platform.timebase_freq) sprint("Timebase frequency: %ld Hz\n", g_platform.timebase_freq);
+  if (g_platform.clint.base) sprint("CLINT at 0x%lx\n", g_platform.clint.base);
+  if (g_platform.plic.base)
+    sprint("PLIC at 0x%lx, %d sources\n", g_platform.plic.base, g_platform.plic_ndev);
+  if (g_platform.uart.base)
+    sprint("UART at 0x%lx, irq %d\n", g_platform.uart.base, g_platform.uart_irq);
 }
 
 //
@@ -57,9 +82,13 @@ static void delegate_traps() {
 
   // macros used in following two statements are defined in kernel/riscv.h
   uintptr_t interrupts = MIP_SSIP | MIP_STIP | MIP_SEIP;
+  // illegal instructions of the user include its first FP instruction, see kernel/fp.c.
+  // access faults include those on the guard of the user stack, see kernel/ustack.c
   uintptr_t exceptions = (1U << CAUSE_MISALIGNED_FETCH) | (1U << CAUSE_FETCH_PAGE_FAULT) |
                          (1U << CAUSE_BREAKPOINT) | (1U << CAUSE_LOAD_PAGE_FAULT) |
-                         (1U << CAUSE_STORE_PAGE_FAULT) | (1U << CAUSE_USER_ECALL);
+                         (1U << CAUSE_STORE_PAGE_FAULT) | (1U << CAUSE_USER_ECALL) |
+                         (1U << CAUSE_ILLEGAL_INSTRUCTION) | (1U << CAUSE_LOAD_ACCESS) |
+                         (1U << CAUSE_STORE_ACCESS);
 
   // writes 64-bit values (interrupts and exceptions) to 'mideleg' and 'medeleg' (two
   // priviledged registers of RV64G machine) respectively.
@@ -71,19 +100,61 @@ static void delegate_traps() {
   assert(read_csr(medeleg) == exceptions);
 }
 
+//
+// set up the physical memory protection. entry 3 lets S and U modes access all memory, but
+// entry 2, which takes priority, denies them the guard of the kernel stack (KSTACK_GUARD in
+// kernel/config.h). entries 0 and 1 are left for the guard of the user stack (see
+// MCALL_PMP_GUARD in kernel/machine/mtrap.c). entry 1 stays off until then.
+//
+static void pmp_init() {
+  // NAPOT: the low bits of the address, up to the first 0, encode the size (of 8 << bits)
+  write_csr(pmpaddr2, (KSTACK_GUARD >> PMP_SHIFT) | (KSTACK_GUARD_SIZE / 8 - 1));
+  // NAPOT with all address bits set covers the whole address space
+  write_csr(pmpaddr3, -1UL);
+  write_csr(pmpcfg0, (uint64)PMP_NAPOT << 16 | (uint64)(PMP_NAPOT | PMP_R | PMP_W | PMP_X) << 24);
+}
+
 //
 // m_start: machine mode C entry point.
 //
 void m_start(uintptr_t hartid, uintptr_t dtb) {
+  // keep the hartid in tp, where the kernel looks for it (see read_tp() in kernel/riscv.h).
+  // mret leaves tp untouched, so s_start() finds it there too.
+  write_tp(hartid);
+  // boot_mark() is defined in kernel/boot.h, it timestamps the boot phases
+  boot_mark(BOOT_MSTART);
+
   // init the spike file interface (stdin,stdout,stderr)
   // functions with "spike_" prefix are all defined in codes under spike_interface/,
   // sprint is also defined in spike_interface/spike_utils.c
   spike_file_init();
+  boot_mark(BOOT_FILE_INIT);
   sprint("In m_start, hartid:%d\n", hartid);
 
   // init HTIF (Host-Target InterFace) and memory by using the Device Table Blob (DTB)
   // init_dtb() is defined above.
   init_dtb(dtb);
+  boot_mark(BOOT_DTB);
+
+  // turn on the vector unit if the hart has one, and let memcpy() and friends (defined in
+  // util/string.c) use it. supports_extension() is defined in kernel/riscv.h
+  if (supports_extension('V')) {
+    write_csr(mstatus, read_csr(mstatus) | MSTATUS_VS_INITIAL);
+    string_enable_vector();
+    // and switch the vector registers between processes lazily (kernel/vector.c)
+    g_vec_available = 1;
+    sprint("Vector extension is available, using vectorized string routines.\n");
+  }
+
+  // the FP unit is switched lazily between processes by the S-mode kernel (kernel/fp.c),
+  // which needs both F and D to save and restore the registers.
+  g_fp_available = supports_extension('F') && supports_extension('D');
+
+  // let S-mode read the cycle, time and instret counters, e.g., for timestamping traces,
+  // and the event counters we find. S-mode passes them on to the user (see kernel/hpm.c).
+  write_csr(mcounteren, COUNTEREN_CY | COUNTEREN_TM | COUNTEREN_IR);
+  // hpm_probe() is defined in kernel/machine/mhpm.c
+  hpm_probe();
 
   // set previous privilege mode to S (Supervisor), and will enter S mode after 'mret'
   // write_csr is a macro defined in kernel/riscv.h
@@ -96,6 +167,18 @@ void m_start(uintptr_t hartid, uintptr_t dtb) {
   // delegate_traps() is defined above.
   delegate_traps();
 
+  // pmp_init() is defined above
+  pmp_init();
+
+  // M-mode traps (the timer interrupt) enter mtrapvec, which saves the interrupted
+  // registers in g_itrframe[hartid] found through mscratch, and runs on mstack.
+  write_csr(mscratch, (uint64)&g_itrframe[hartid]);
+  write_csr(mtvec, (uint64)mtrapvec);
+
+  // start the timer. mstatus.MIE is left clear: the timer interrupts S and U modes anyway,
+  // and M-mode is not to be interrupted by its own traps.
+  timerinit(hartid);
+
   // switch to supervisor mode (S mode) and jump to s_start(), i.e., set pc to mepc
   asm volatile("mret");
 }
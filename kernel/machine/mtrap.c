@@ -0,0 +1,116 @@
+/*
+ * Machine-mode trap handling: the timer interrupt, and the faults of M-mode itself.
+ */
+
+#include "kernel/riscv.h"
+#include "kernel/config.h"
+#include "kernel/profile.h"
+#include "kernel/mcall.h"
+#include "kernel/hpm.h"
+#include "kernel/timer.h"
+#include "spike_interface/spike_utils.h"
+
+// the CLINT of the machine, decided by timerinit() from the DTB
+static uint64 clint_base;
+// mtime at tick 0, and the number of mtime units between two ticks
+uint64 g_timer_base, g_timer_interval;
+uint64 g_timer_raised[NCPU];
+
+static void set_mtimecmp(uint64 hartid, uint64 mtime) {
+  *(uint64 *)CLINT_MTIMECMP(clint_base, hartid) = mtime;
+}
+
+//
+// program the first tick of hartid, and let the timer interrupt M-mode.
+//
+void timerinit(uintptr_t hartid) {
+  clint_base = g_platform.clint.base ? g_platform.clint.base : CLINT_BASE_DEFAULT;
+  g_timer_interval = g_platform.timebase_freq ? g_platform.timebase_freq / TIMER_HZ
+                                              : TIMER_INTERVAL_DEFAULT;
+  g_timer_base = *(uint64 *)CLINT_MTIME(clint_base);
+
+  // fire the first timer interrupt after g_timer_interval. a tickless kernel arms the
+  // timer itself, with MCALL_TIMER_SET.
+  set_mtimecmp(hartid, TIMER_PERIODIC ? g_timer_base + g_timer_interval : -1);
+
+  // enable the machine-mode timer interrupt
+  write_csr(mie, read_csr(mie) | MIE_MTIE);
+}
+
+//
+// a tick: take a profile sample of the interrupted code, arm the next tick, and forward the
+// tick to the S-mode kernel as a software interrupt (the timer itself can not be delegated).
+// a tickless kernel arms the next one after it runs its expired timers.
+//
+static void handle_timer(void) {
+  uint64 hartid = read_csr(mhartid);
+  // the privilege mode the interrupt came from is kept in mstatus.MPP.
+  // profile_sample() is defined in kernel/profile.c
+  int from_kernel = (read_csr(mstatus) & MSTATUS_MPP_MASK) != MSTATUS_MPP_U;
+  profile_sample(hartid, read_csr(mepc), from_kernel);
+
+  // setup the next timer interrupt. writing mtimecmp also clears the pending one.
+  set_mtimecmp(hartid, TIMER_PERIODIC ? *(uint64 *)CLINT_MTIME(clint_base) + g_timer_interval
+                                      : -1);
+
+  // raise a software interrupt for S-mode, see handle_mtimer_trap() in kernel/strap.c
+  g_timer_raised[hartid] = *(uint64 *)CLINT_MTIME(clint_base);
+  write_csr(sip, read_csr(sip) | SIP_SSIP);
+}
+
+//
+// serve an ecall from the S-mode kernel. the call number and arguments are in the
+// registers saved by mtrapvec, see kernel/mcall.h
+//
+static void handle_mcall(riscv_regs *regs) {
+  long ret = -1;
+  switch (regs->a7) {
+    case MCALL_HPM_SET:
+      if (regs->a0 >= HPM_FIRST && regs->a0 < HPM_FIRST + HPM_NCOUNTERS &&
+          (g_hpm_mask & (1 << regs->a0))) {
+        mhpm_set(regs->a0, regs->a1, regs->a2);
+        ret = 0;
+      }
+      break;
+    case MCALL_PMP_GUARD:
+      // PMP entry 1 covers [pmpaddr0, pmpaddr1) with no permissions, and takes priority
+      // over the entry 3 that allows all, see pmp_init() in kernel/machine/minit.c
+      write_csr(pmpaddr0, regs->a0 >> PMP_SHIFT);
+      write_csr(pmpaddr1, regs->a1 >> PMP_SHIFT);
+      write_csr(pmpcfg0, (read_csr(pmpcfg0) & ~0xff00UL) | (PMP_TOR << 8));
+      // the accesses that follow must see the new guard
+      asm volatile("sfence.vma");
+      ret = 0;
+      break;
+    case MCALL_TIMER_SET:
+      set_mtimecmp(read_csr(mhartid),
+                   regs->a0 == -1 ? -1 : g_timer_base + regs->a0 * g_timer_interval);
+      ret = 0;
+      break;
+  }
+  regs->a0 = ret;
+  // resume after the ecall
+  write_csr(mepc, read_csr(mepc) + 4);
+}
+
+//
+// handle_mtrap calls a handling function according to the type of a machine mode interrupt
+// (trap). it is called by mtrapvec in kernel/machine/mtrap_vector.S
+//
+void handle_mtrap() {
+  uint64 mcause = read_csr(mcause);
+  switch (mcause) {
+    case CAUSE_MTIMER:
+      handle_timer();
+      break;
+    case CAUSE_SUPERVISOR_ECALL:
+      // mscratch points to the registers saved by mtrapvec
+      handle_mcall((riscv_regs *)read_csr(mscratch));
+      break;
+    default:
+      sprint("machine trap(): unexpected mcause %p\n", mcause);
+      sprint("            mepc=%p mtval=%p\n", read_csr(mepc), read_csr(mtval));
+      panic("unexpected exception happened in M-mode.\n");
+      break;
+  }
+}
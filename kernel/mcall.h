@@ -0,0 +1,27 @@
+#ifndef _MCALL_H_
+#define _MCALL_H_
+
+#include "util/types.h"
+
+//
+// calls from the S-mode kernel to M-mode, for what only M-mode may do (in the spirit of
+// the SBI). ecall from S-mode is not delegated, so it reaches handle_mtrap() in
+// kernel/machine/mtrap.c. a7 holds the call number, a0-a2 the arguments, a0 the result.
+//
+// program mhpmevent<a0> with the event a1, and set mhpmcounter<a0> to a2
+#define MCALL_HPM_SET 1
+// interrupt at tick a0 (see kernel/timer.c), or never if a0 is -1
+#define MCALL_TIMER_SET 2
+// deny S and U modes access to [a0, a1), the guard of the user stack (see kernel/ustack.c)
+#define MCALL_PMP_GUARD 3
+
+static inline long mcall(long num, long arg0, long arg1, long arg2) {
+  register long a0 asm("a0") = arg0;
+  register long a1 asm("a1") = arg1;
+  register long a2 asm("a2") = arg2;
+  register long a7 asm("a7") = num;
+  asm volatile("ecall" : "+r"(a0) : "r"(a1), "r"(a2), "r"(a7) : "memory");
+  return a0;
+}
+
+#endif
@@ -0,0 +1,185 @@
+/*
+ * pipes. a pipe holds its data in a ring of pages. small writes are copied into kernel
+ * pages, while every whole, page-aligned page of a write is gifted to the pipe: the pipe
+ * keeps a reference to the user page and reads it in place, so the data is copied once,
+ * to the reader, or never, when pipe_splice() sends it to a host file.
+ *
+ * as with vmsplice(SPLICE_F_GIFT) in Linux, the writer must leave a gifted page alone
+ * until the data is read. lab1 runs without paging, so the page can not be taken away
+ * from the writer by unmapping it: this is a rule for the writer, not enforced.
+ *
+ * lab1 has one process, which can not sleep until the other end of a pipe moves. reads of
+ * an empty pipe and writes to a full one return -1 instead of blocking.
+ */
+
+#include "pipe.h"
+#include "riscv.h"
+#include "pmm.h"
+#include "process.h"
+#include "trace.h"
+#include "console.h"
+#include "util/functions.h"
+#include "util/string.h"
+
+#include "spike_interface/spike_utils.h"
+
+static struct {
+  uint64 copied, gifted, spliced;
+} pipe_stats;
+
+static pipe_fd *fd_get(process *proc, int fd, int writable) {
+  if (fd < 0 || fd >= PROC_MAX_FDS || !proc->fds[fd].p) return 0;
+  return proc->fds[fd].writable == writable ? &proc->fds[fd] : 0;
+}
+
+int pipe_create(process *proc, int *fds) {
+  // the two lowest free descriptors, after those of the console
+  int rfd = -1, wfd = -1;
+  for (int fd = CONSOLE_NFDS; fd < PROC_MAX_FDS && wfd < 0; fd++)
+    if (!proc->fds[fd].p) {
+      if (rfd < 0)
+        rfd = fd;
+      else
+        wfd = fd;
+    }
+  if (wfd < 0) return -1;
+
+  pipe_ring *p = (pipe_ring *)alloc_page();
+  if (!p) return -1;
+  memset(p, 0, sizeof(pipe_ring));
+  p->readers = p->writers = 1;
+  proc->fds[rfd] = (pipe_fd){p, 0};
+  proc->fds[wfd] = (pipe_fd){p, 1};
+  fds[0] = rfd;
+  fds[1] = wfd;
+  return 0;
+}
+
+static pipe_buf *buf_last(pipe_ring *p) {
+  return p->nbufs ? &p->bufs[(p->head + p->nbufs - 1) % PIPE_MAX_BUFS] : 0;
+}
+
+static pipe_buf *buf_push(pipe_ring *p, char *page, uint32 len, int gift) {
+  pipe_buf *b = &p->bufs[(p->head + p->nbufs++) % PIPE_MAX_BUFS];
+  *b = (pipe_buf){page, 0, len, gift};
+  return b;
+}
+
+// drop n bytes from the front of the pipe, all of them in its first buffer
+static void buf_consume(pipe_ring *p, uint64 n) {
+  pipe_buf *b = &p->bufs[p->head];
+  b->off += n;
+  b->len -= n;
+  if (b->len) return;
+  if (!b->gift) free_page(b->page);
+  p->head = (p->head + 1) % PIPE_MAX_BUFS;
+  p->nbufs--;
+}
+
+static int is_user_page(const char *va) {
+  return (uint64)va >= g_mem_layout.user_start &&
+         (uint64)va + PGSIZE <= g_mem_layout.user_stack_top;
+}
+
+int64 pipe_write(process *proc, int fd, const char *buf, uint64 n) {
+  pipe_fd *f = fd_get(proc, fd, 1);
+  if (!f || !f->p->readers) return -1;
+  pipe_ring *p = f->p;
+
+  uint64 done = 0;
+  while (done < n) {
+    const char *src = buf + done;
+    uint64 left = n - done;
+
+    if ((uint64)src % PGSIZE == 0 && left >= PGSIZE && is_user_page(src)) {
+      if (p->nbufs == PIPE_MAX_BUFS) break;
+      buf_push(p, (char *)src, PGSIZE, 1);
+      pipe_stats.gifted += PGSIZE;
+      done += PGSIZE;
+      continue;
+    }
+
+    // copy into the room left in the last kernel page, or into a new one
+    pipe_buf *last = buf_last(p);
+    if (!last || last->gift || last->off + last->len == PGSIZE) {
+      char *page = p->nbufs < PIPE_MAX_BUFS ? alloc_page() : 0;
+      if (!page) break;
+      last = buf_push(p, page, 0, 0);
+    }
+    uint64 chunk = MIN(left, PGSIZE - (last->off + last->len));
+    // stop at the next page of src, if it can be gifted
+    uint64 to_page = PGSIZE - (uint64)src % PGSIZE;
+    if (left >= to_page + PGSIZE) chunk = MIN(chunk, to_page);
+
+    memcpy(last->page + last->off + last->len, src, chunk);
+    last->len += chunk;
+    pipe_stats.copied += chunk;
+    done += chunk;
+  }
+  return done ? done : -1;
+}
+
+int64 pipe_read(process *proc, int fd, char *buf, uint64 n) {
+  pipe_fd *f = fd_get(proc, fd, 0);
+  if (!f) return -1;
+  pipe_ring *p = f->p;
+  if (!p->nbufs) return p->writers ? -1 : 0;
+
+  uint64 done = 0;
+  while (done < n && p->nbufs) {
+    pipe_buf *b = &p->bufs[p->head];
+    uint64 chunk = MIN(n - done, b->len);
+    memcpy(buf + done, b->page + b->off, chunk);
+    buf_consume(p, chunk);
+    done += chunk;
+  }
+  return done;
+}
+
+int64 pipe_splice(process *proc, int fd, const char *path, uint64 n) {
+  pipe_fd *f = fd_get(proc, fd, 0);
+  if (!f) return -1;
+  pipe_ring *p = f->p;
+  if (!p->nbufs) return p->writers ? -1 : 0;
+
+  spike_file_t *file = spike_file_open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (IS_ERR_VALUE(file)) return -1;
+
+  trace_begin("pipe splice %ld", n);
+  uint64 done = 0;
+  while (done < n && p->nbufs) {
+    pipe_buf *b = &p->bufs[p->head];
+    uint64 chunk = MIN(n - done, b->len);
+    if (spike_file_write(file, b->page + b->off, chunk) != chunk) break;
+    buf_consume(p, chunk);
+    done += chunk;
+  }
+  trace_end("pipe splice");
+  spike_file_close(file);
+
+  pipe_stats.spliced += done;
+  return done ? done : -1;
+}
+
+int pipe_close(process *proc, int fd) {
+  if (fd < 0 || fd >= PROC_MAX_FDS || !proc->fds[fd].p) return -1;
+  pipe_ring *p = proc->fds[fd].p;
+  if (proc->fds[fd].writable)
+    p->writers--;
+  else
+    p->readers--;
+  proc->fds[fd].p = 0;
+
+  if (p->readers || p->writers) return 0;
+  while (p->nbufs) buf_consume(p, p->bufs[p->head].len);
+  free_page(p);
+  return 0;
+}
+
+static void pipe_report(int code, int panic) {
+  if (!pipe_stats.copied && !pipe_stats.gifted) return;
+  sprint("pipes: %ld bytes copied in, %ld bytes gifted, %ld bytes spliced to host files\n",
+         pipe_stats.copied, pipe_stats.gifted, pipe_stats.spliced);
+}
+
+void pipe_init(void) { register_shutdown_hook(pipe_report); }
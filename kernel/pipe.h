@@ -0,0 +1,45 @@
+#ifndef _PIPE_H_
+#define _PIPE_H_
+
+#include "util/types.h"
+
+// pages a pipe holds at most, and file descriptors a process can have open
+#define PIPE_MAX_BUFS 16
+#define PROC_MAX_FDS 16
+
+// a piece of pipe data: [off, off + len) of page. page is a kernel page the data was
+// copied to, or a gifted page of the writer (gift set), which the pipe reads in place.
+typedef struct pipe_buf_t {
+  char *page;
+  uint32 off, len;
+  int gift;
+} pipe_buf;
+
+typedef struct pipe_t {
+  pipe_buf bufs[PIPE_MAX_BUFS];  // a ring, the data of bufs[head] is read first
+  int head, nbufs;
+  int readers, writers;  // open ends
+} pipe_ring;
+
+// an open file descriptor of a process. all of them are pipe ends in PKE, but for the
+// console below CONSOLE_NFDS (see kernel/console.h).
+typedef struct pipe_fd_t {
+  pipe_ring *p;  // NULL if the descriptor is free
+  int writable;
+} pipe_fd;
+
+struct process_t;
+// create a pipe, and store its read and write descriptors in fds[0] and fds[1]
+int pipe_create(struct process_t *proc, int *fds);
+int pipe_close(struct process_t *proc, int fd);
+// return the number of bytes read or written, or -1 if the pipe is empty (full) while the
+// other end is open. read returns 0 at end of file.
+int64 pipe_read(struct process_t *proc, int fd, char *buf, uint64 n);
+int64 pipe_write(struct process_t *proc, int fd, const char *buf, uint64 n);
+// move up to n bytes from the pipe to the end of the host file at path, without passing
+// them through user memory. returns the number of bytes moved, or -1.
+int64 pipe_splice(struct process_t *proc, int fd, const char *path, uint64 n);
+// report the pipe statistics at shutdown
+void pipe_init(void);
+
+#endif
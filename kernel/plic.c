@@ -0,0 +1,121 @@
+/*
+ * the platform-level interrupt controller, which brings the interrupts of the devices
+ * (e.g., the UART, see kernel/uart.c) to the harts as external interrupts. the kernel takes
+ * them in S-mode: MIP_SEIP is delegated (see delegate_traps() in kernel/machine/minit.c).
+ *
+ * drivers register a handler per source, with its priority and the harts it may interrupt.
+ * a source is enabled only in the S-mode contexts of those harts, so that I/O can be kept
+ * off the harts that compute. plic_handle() claims the pending sources in the external
+ * interrupt, runs their handlers, and completes them; the claims are counted per source
+ * and hart, and reported at shutdown.
+ */
+
+#include "plic.h"
+#include "riscv.h"
+#include "config.h"
+
+#include "spike_interface/spike_utils.h"
+
+// register layout of the riscv,plic0
+#define PLIC_PRIORITY(irq) (4 * (irq))
+#define PLIC_ENABLE(ctx) (0x2000 + 0x80 * (ctx))
+#define PLIC_THRESHOLD(ctx) (0x200000 + 0x1000 * (ctx))
+#define PLIC_CLAIM(ctx) (PLIC_THRESHOLD(ctx) + 4)
+
+// on spike (and QEMU virt), context 2h is the M-mode of hart h, and 2h + 1 its S-mode
+#define PLIC_SCONTEXT(hart) (2 * (hart) + 1)
+
+// the harts that run the kernel, which can serve interrupts
+#define PLIC_KERNEL_HARTS ((1UL << NCPU) - 1)
+
+typedef struct plic_source_t {
+  plic_handler fn;  // NULL if the source is not registered
+  void *arg;
+  const char *name;
+  uint64 harts;  // routed to these harts
+  uint64 count[NCPU];
+} plic_source;
+
+static plic_source sources[PLIC_MAX_IRQS];
+// claims that found no handler
+static uint64 spurious[NCPU];
+
+static inline volatile uint32 *plic_reg(uint64 off) {
+  return (volatile uint32 *)(g_platform.plic.base + off);
+}
+
+// the sources the DTB says the PLIC has, within what we can serve
+static uint32 plic_nirqs(void) {
+  uint32 n = g_platform.plic_ndev + 1;
+  return n < PLIC_MAX_IRQS ? n : PLIC_MAX_IRQS;
+}
+
+static void plic_set_enable(uint64 hart, uint32 irq, int on) {
+  volatile uint32 *enable = plic_reg(PLIC_ENABLE(PLIC_SCONTEXT(hart))) + irq / 32;
+  if (on)
+    *enable |= 1U << (irq % 32);
+  else
+    *enable &= ~(1U << (irq % 32));
+}
+
+static void plic_report(int code, int panic) {
+  for (uint32 irq = 1; irq < PLIC_MAX_IRQS; irq++) {
+    if (!sources[irq].fn) continue;
+    sprint("plic irq %d (%s), harts 0x%lx:", irq, sources[irq].name, sources[irq].harts);
+    for (int hart = 0; hart < NCPU; hart++) sprint(" %ld", sources[irq].count[hart]);
+    sprint(" interrupts\n");
+  }
+  for (int hart = 0; hart < NCPU; hart++)
+    if (spurious[hart]) sprint("plic: %ld spurious claims on hart %d\n", spurious[hart], hart);
+}
+
+void plic_init(void) {
+  if (!g_platform.plic.base) return;
+  if (read_tp() == 0) register_shutdown_hook(plic_report);
+  // take sources of any priority above 0
+  *plic_reg(PLIC_THRESHOLD(PLIC_SCONTEXT(read_tp()))) = 0;
+}
+
+int plic_register(uint32 irq, const char *name, uint32 priority, uint64 harts,
+                  plic_handler fn, void *arg) {
+  if (!g_platform.plic.base || irq == 0 || irq >= plic_nirqs() || sources[irq].fn || !fn)
+    return -1;
+  if (!(harts & PLIC_KERNEL_HARTS)) return -1;
+
+  sources[irq] = (plic_source){.fn = fn, .arg = arg, .name = name};
+  if (priority < 1) priority = 1;
+  if (priority > PLIC_MAX_PRIORITY) priority = PLIC_MAX_PRIORITY;
+  *plic_reg(PLIC_PRIORITY(irq)) = priority;
+  return plic_route(irq, harts);
+}
+
+int plic_route(uint32 irq, uint64 harts) {
+  if (irq == 0 || irq >= plic_nirqs() || !sources[irq].fn) return -1;
+  harts &= PLIC_KERNEL_HARTS;
+  if (!harts) return -1;
+
+  // enable first, so that the source is not left without a hart in between
+  for (int hart = 0; hart < NCPU; hart++)
+    if (harts & (1UL << hart)) plic_set_enable(hart, irq, 1);
+  for (int hart = 0; hart < NCPU; hart++)
+    if (!(harts & (1UL << hart))) plic_set_enable(hart, irq, 0);
+  sources[irq].harts = harts;
+  return 0;
+}
+
+void plic_handle(void) {
+  uint64 hart = read_tp();
+  volatile uint32 *claim = plic_reg(PLIC_CLAIM(PLIC_SCONTEXT(hart)));
+  uint32 irq;
+  // each claim takes the highest priority source pending, until none is left
+  while ((irq = *claim)) {
+    if (irq < PLIC_MAX_IRQS && sources[irq].fn) {
+      sources[irq].count[hart]++;
+      sources[irq].fn(irq, sources[irq].arg);
+    } else {
+      spurious[hart]++;
+    }
+    // complete: the source may interrupt again
+    *claim = irq;
+  }
+}
@@ -0,0 +1,29 @@
+#ifndef _PLIC_H_
+#define _PLIC_H_
+
+#include "util/types.h"
+
+// interrupt sources the kernel can serve: 1 .. PLIC_MAX_IRQS - 1 (0 means "none")
+#define PLIC_MAX_IRQS 128
+// priorities of sources run from 1 (lowest) to PLIC_MAX_PRIORITY; 0 would mask them
+#define PLIC_MAX_PRIORITY 7
+
+// serves the interrupt of source irq, with interrupts off. arg is given at registration.
+typedef void (*plic_handler)(uint32 irq, void *arg);
+
+// let the PLIC of the DTB, if any, interrupt the S-mode context of this hart. called on
+// every hart.
+void plic_init(void);
+//
+// serve source irq with fn, at priority, on the harts in the mask harts (bit h for hart h).
+// name is for the statistics. returns 0, or -1 if irq is invalid or taken, or no hart
+// that runs the kernel is in harts.
+//
+int plic_register(uint32 irq, const char *name, uint32 priority, uint64 harts,
+                  plic_handler fn, void *arg);
+// steer a registered source to the harts in the mask harts instead. returns 0, or -1.
+int plic_route(uint32 irq, uint64 harts);
+// claim the pending sources routed to this hart, and run their handlers
+void plic_handle(void);
+
+#endif
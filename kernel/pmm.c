@@ -0,0 +1,109 @@
+/*
+ * physical memory management of PKE: decides the memory layout from the size of the
+ * emulated memory, and manages the free pages between the kernel image and USER_BASE.
+ */
+
+#include "pmm.h"
+#include "riscv.h"
+#include "config.h"
+#include "util/functions.h"
+
+#include "spike_interface/spike_utils.h"
+
+// _ftext and _end are defined in kernel/kernel.lds, they mark the beginning and the end of
+// the PKE kernel image
+extern char _ftext[], _end[];
+// g_mem_size is defined in spike_interface/spike_platform.c, it indicates the size of our
+// (emulated) spike machine, as found in the DTB.
+extern uint64 g_mem_size;
+
+mem_layout g_mem_layout;
+
+typedef struct node {
+  struct node *next;
+} list_node;
+
+// g_free_mem_list is the head of the list of free physical memory pages
+static list_node g_free_mem_list;
+// and the number of pages on it
+static uint64 nfree_pages;
+
+//
+// place a physical page at *pa to the free list of g_free_mem_list (to reclaim the page)
+//
+void free_page(void *pa) {
+  if (((uint64)pa % PGSIZE) != 0 || (uint64)pa < g_mem_layout.kfree_start ||
+      (uint64)pa >= g_mem_layout.kfree_end)
+    panic("free_page 0x%lx \n", pa);
+
+  list_node *n = (list_node *)pa;
+  n->next = g_free_mem_list.next;
+  g_free_mem_list.next = n;
+  nfree_pages++;
+}
+
+//
+// takes the first free page from g_free_mem_list, and returns (allocates) it.
+//
+void *alloc_page() {
+  list_node *n = g_free_mem_list.next;
+  if (n) {
+    g_free_mem_list.next = n->next;
+    nfree_pages--;
+  }
+  return (void *)n;
+}
+
+uint64 free_page_count(void) { return nfree_pages; }
+
+//
+// actually creates the free page list. each page occupies 4KB (PGSIZE).
+//
+static void create_freepage_list(uint64 start, uint64 end) {
+  g_free_mem_list.next = 0;
+  nfree_pages = 0;
+  for (uint64 p = start; p + PGSIZE <= end; p += PGSIZE) free_page((void *)p);
+}
+
+//
+// lay out the emulated memory: [kernel image][kernel free pages][guard][kernel stack]
+// USER_BASE [user program][shared memory][user stack] top of memory.
+//
+void pmm_init() {
+  mem_layout *l = &g_mem_layout;
+  uint64 mem_end = DRAM_BASE + g_mem_size;
+
+  l->kernel_start = (uint64)_ftext;
+  l->kernel_end = (uint64)_end;
+  if (l->kernel_end > KSTACK_GUARD || mem_end <= USER_BASE)
+    panic("PKE kernel (end 0x%lx) and memory (end 0x%lx) do not fit USER_BASE 0x%lx.\n",
+          l->kernel_end, mem_end, USER_BASE);
+
+  l->kfree_start = ROUNDUP(l->kernel_end, PGSIZE);
+  l->kfree_end = KSTACK_GUARD;
+  l->kstack_bottom = KSTACK_GUARD + KSTACK_GUARD_SIZE;
+  l->kstack_top = USER_BASE;
+
+  uint64 stack_size = ROUNDDOWN((mem_end - USER_BASE) / USER_STACK_FRACTION, PGSIZE);
+  stack_size = MAX(stack_size, USER_STACK_MIN);
+  if (stack_size + SHM_SIZE >= mem_end - USER_BASE)
+    panic("emulated memory is too small for user stack and shared memory.\n");
+
+  l->user_stack_top = ROUNDDOWN(mem_end, PGSIZE);
+  l->user_stack_bottom = l->user_stack_top - stack_size;
+  l->shm_end = l->user_stack_bottom;
+  l->shm_start = l->shm_end - ROUNDUP(SHM_SIZE, PGSIZE);
+  l->user_start = USER_BASE;
+  l->user_end = l->shm_start;
+
+  sprint("Memory layout:\n");
+  sprint("  kernel       [0x%lx, 0x%lx)\n", l->kernel_start, l->kernel_end);
+  sprint("  kernel free  [0x%lx, 0x%lx)\n", l->kfree_start, l->kfree_end);
+  sprint("  kernel stack [0x%lx, 0x%lx)\n", l->kstack_bottom, l->kstack_top);
+  sprint("  user program [0x%lx, 0x%lx)\n", l->user_start, l->user_end);
+  sprint("  shared mem   [0x%lx, 0x%lx)\n", l->shm_start, l->shm_end);
+  sprint("  user stack   [0x%lx, 0x%lx), %ld KB\n", l->user_stack_bottom, l->user_stack_top,
+         stack_size >> 10);
+
+  create_freepage_list(l->kfree_start, l->kfree_end);
+}
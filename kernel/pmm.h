@@ -0,0 +1,34 @@
+#ifndef _PMM_H_
+#define _PMM_H_
+
+#include "util/types.h"
+
+// the memory layout chosen at boot. all regions are [start, end) physical addresses.
+typedef struct mem_layout_t {
+  // the PKE kernel image, i.e., [_ftext, _end) in kernel/kernel.lds
+  uint64 kernel_start, kernel_end;
+  // free pages handed out by alloc_page(), lying between the kernel image and the guard of
+  // the kernel stack
+  uint64 kfree_start, kfree_end;
+  // the kernel stack, right below USER_BASE
+  uint64 kstack_bottom, kstack_top;
+  // segments of the user program must fall in here
+  uint64 user_start, user_end;
+  // named shared memory regions are handed out from here, see kernel/shm.c
+  uint64 shm_start, shm_end;
+  // the user stack, growing downwards from user_stack_top
+  uint64 user_stack_bottom, user_stack_top;
+} mem_layout;
+
+extern mem_layout g_mem_layout;
+
+// computes the memory layout and initializes the free page list
+void pmm_init();
+// allocate one free page (of PGSIZE bytes), returns NULL if none is left
+void *alloc_page();
+// give back a page obtained from alloc_page()
+void free_page(void *pa);
+// the number of free pages left
+uint64 free_page_count(void);
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef _PREEMPT_H_
+#define _PREEMPT_H_
+
+#include "riscv.h"
+#include "config.h"
+
+//
+// the preempt count of a hart is above 0 while the kernel code running on it must not be
+// preempted: in an interrupt handler, or between preempt_disable() and preempt_enable().
+// defined in kernel/strap.c
+//
+extern int g_preempt_count[NCPU];
+
+static inline void preempt_disable(void) {
+  g_preempt_count[read_tp()]++;
+  asm volatile("" : : : "memory");
+}
+
+static inline void preempt_enable(void) {
+  asm volatile("" : : : "memory");
+  g_preempt_count[read_tp()]--;
+}
+
+// called in long loops of the kernel: if it runs with interrupts off but may be preempted,
+// take the pending interrupts now rather than when the loop is over
+void preempt_point(void);
+
+#endif
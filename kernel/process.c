@@ -12,6 +12,10 @@
 #include "process.h"
 #include "elf.h"
 #include "string.h"
+#include "boot.h"
+#include "trace.h"
+#include "ustack.h"
+#include "kinfo.h"
 
 #include "spike_interface/spike_utils.h"
 
@@ -27,7 +31,24 @@ process* current = NULL;
 //
 void switch_to(process* proc) {
   assert(proc);
+  // no more kernel traps: stvec is about to point to the vector for user traps
+  intr_off();
+  // hand the performance counters and the FP unit over to proc. hpm_switch() and
+  // fp_switch() are defined in kernel/hpm.c and kernel/fp.c
+  if (proc != current) {
+    trace("switch to pid %d", proc->pid);
+    if (current) g_kstats.switches++;
+    hpm_switch(current, proc);
+    fp_switch(current, proc);
+    // guard the stack of proc. ustack_switch() is defined in kernel/ustack.c
+    ustack_switch(proc);
+  }
+  // vec_switch() is defined in kernel/vector.c
+  vec_switch(current, proc);
   current = proc;
+  // let the process see the kernel state without syscalls. kinfo_update() is defined in
+  // kernel/kinfo.c
+  kinfo_update(proc);
 
   // write the smode_trap_vector (64-bit func. address) defined in kernel/strap_vector.S
   // to the stvec privilege register, such that trap handler pointed by smode_trap_vector
@@ -38,6 +59,7 @@ void switch_to(process* proc) {
   // the process next re-enters the kernel.
   proc->trapframe->kernel_sp = proc->kstack;  // process's kernel stack
   proc->trapframe->kernel_trap = (uint64)smode_trap_handler;
+  proc->trapframe->kernel_hartid = read_tp();
 
   // SSTATUS_SPP and SSTATUS_SPIE are defined in kernel/riscv.h
   // set S Previous Privilege mode (the SSTATUS_SPP bit in sstatus register) to User mode.
@@ -51,6 +73,13 @@ void switch_to(process* proc) {
   // set S Exception Program Counter (sepc register) to the elf entry pc.
   write_csr(sepc, proc->trapframe->epc);
 
+  // the boot is over once the first process is about to run. boot_report() is defined in
+  // kernel/boot.c
+  if (!g_boot_record.cycles[BOOT_USER]) {
+    boot_mark(BOOT_USER);
+    boot_report();
+  }
+
   // return_to_user() is defined in kernel/strap_vector.S. switch to user mode with sret.
   return_to_user(proc->trapframe);
 }
@@ -2,6 +2,10 @@
 #define _PROC_H_
 
 #include "riscv.h"
+#include "hpm.h"
+#include "fp.h"
+#include "vector.h"
+#include "pipe.h"
 
 typedef struct trapframe_t {
   // space to store context (all common registers)
@@ -13,14 +17,36 @@ typedef struct trapframe_t {
   /* offset:256 */ uint64 kernel_trap;
   // saved user process counter
   /* offset:264 */ uint64 epc;
+  // hartid to be loaded into tp when entering the kernel, as tp belongs to the user
+  /* offset:272 */ uint64 kernel_hartid;
 }trapframe;
 
 // the extremely simple definition of process, used for begining labs of PKE
 typedef struct process_t {
+  // process id, 0 is reserved for "no process" (e.g., in kernel traces)
+  int pid;
   // pointing to the stack used in trap handling.
   uint64 kstack;
   // trapframe storing the context of a (User mode) process.
   trapframe* trapframe;
+  // events selected on the performance counters (0 for none), and the counts saved while
+  // the process is not running. see kernel/hpm.c
+  uint64 hpm_event[HPM_NCOUNTERS];
+  uint64 hpm_count[HPM_NCOUNTERS];
+  // floating-point state, see kernel/fp.c. fp is valid unless the process owns the FP
+  // registers, fp_dirty is set if the registers hold changes not saved in fp yet.
+  fp_context fp;
+  int fp_used;
+  int fp_dirty;
+  // vector state, see kernel/vector.c. same rules as for fp.
+  vec_context vec;
+  int vec_used;
+  int vec_dirty;
+  // the user stack: [stack_bottom, stack_top) is in use, and it may grow down to
+  // stack_limit. see kernel/ustack.c
+  uint64 stack_top, stack_bottom, stack_limit;
+  // open file descriptors, see kernel/pipe.c
+  pipe_fd fds[PROC_MAX_FDS];
 }process;
 
 void switch_to(process*);
@@ -0,0 +1,109 @@
+/*
+ * sampling profiler. on every timer tick, the M-mode timer handler hands us the interrupted
+ * pc, which we keep in a buffer of the hart. the samples are attributed to the functions of
+ * the kernel or the application only at shutdown, and written to the host as a "folded"
+ * profile, i.e., lines of "image;function count" which flame graph tools read directly.
+ */
+
+#include "profile.h"
+#include "config.h"
+#include "util/functions.h"
+#include "util/snprintf.h"
+
+#include "spike_interface/spike_utils.h"
+
+// samples of each hart. bit 0 (always 0 in a pc) tells whether the sample is from the kernel.
+static uint64 samples[NCPU][PROFILE_MAX_SAMPLES];
+// number of samples taken by each hart. only the first PROFILE_MAX_SAMPLES are kept.
+static uint64 nsamples[NCPU];
+static volatile int sampling = 0;
+
+typedef struct profile_image_t {
+  const char *name;
+  elf_symtab tab;
+  elf_symbol syms[PROFILE_MAX_SYMS];
+  char names[PROFILE_MAX_NAMES];
+  // samples per symbol, the last entry counts the samples that hit no symbol
+  uint32 counts[PROFILE_MAX_SYMS + 1];
+} profile_image;
+
+static profile_image images[2] = {
+    [PROFILE_KERNEL] = {.name = "kernel"},
+    [PROFILE_USER] = {.name = "user"},
+};
+
+void profile_sample(uint64 hartid, uint64 pc, int from_kernel) {
+  if (!sampling) return;
+  uint64 n = nsamples[hartid]++;
+  if (n < PROFILE_MAX_SAMPLES) samples[hartid][n] = pc | (from_kernel ? 1 : 0);
+}
+
+void profile_load_symbols(int image, elf_ctx *ctx) {
+  profile_image *img = &images[image];
+  img->tab.syms = img->syms;
+  img->tab.max_syms = PROFILE_MAX_SYMS;
+  img->tab.names = img->names;
+  img->tab.max_names = PROFILE_MAX_NAMES;
+
+  elf_status r = elf_load_symbols(ctx, &img->tab);
+  if (r == EL_ENOMEM)
+    sprint("profile: symbol table of %s truncated at %d symbols.\n", img->name, img->tab.nsyms);
+  else if (r != EL_OK)
+    sprint("profile: no symbols for %s, its samples will not be named.\n", img->name);
+}
+
+// the output is gathered in buf, and written to the host in large pieces
+static char buf[4096];
+static uint64 buf_len;
+
+static void flush(spike_file_t *f) {
+  spike_file_write(f, buf, buf_len);
+  buf_len = 0;
+}
+
+static void emit(spike_file_t *f, const char *image, const char *func, uint32 count) {
+  if (sizeof(buf) - buf_len < 128) flush(f);
+  int n = snprintf(buf + buf_len, sizeof(buf) - buf_len, "%s;%s %d\n", image, func, count);
+  buf_len += MIN(n, sizeof(buf) - buf_len - 1);
+}
+
+static void profile_write(int code, int panic) {
+  // the ticks go on during shutdown, but the buffers must hold still
+  sampling = 0;
+
+  uint64 total = 0, dropped = 0;
+  for (int hart = 0; hart < NCPU; hart++) {
+    uint64 n = MIN(nsamples[hart], PROFILE_MAX_SAMPLES);
+    total += nsamples[hart];
+    dropped += nsamples[hart] - n;
+    for (uint64 i = 0; i < n; i++) {
+      uint64 s = samples[hart][i];
+      profile_image *img = &images[s & 1 ? PROFILE_KERNEL : PROFILE_USER];
+      int sym = elf_find_symbol(&img->tab, s & ~1ULL);
+      img->counts[sym < 0 ? img->tab.nsyms : sym]++;
+    }
+  }
+
+  spike_file_t *f = spike_file_open(PROFILE_PATH, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (IS_ERR_VALUE(f)) {
+    sprint("profile: can not create %s.\n", PROFILE_PATH);
+    return;
+  }
+  for (int i = 0; i < ARRAY_SIZE(images); i++) {
+    profile_image *img = &images[i];
+    for (int sym = 0; sym < img->tab.nsyms; sym++)
+      if (img->counts[sym])
+        emit(f, img->name, img->names + img->syms[sym].name, img->counts[sym]);
+    if (img->counts[img->tab.nsyms]) emit(f, img->name, "[unknown]", img->counts[img->tab.nsyms]);
+  }
+  flush(f);
+  spike_file_close(f);
+
+  sprint("profile: %ld samples (%ld dropped) written to %s\n", total, dropped, PROFILE_PATH);
+}
+
+void profile_init(void) {
+  if (!PROFILE_ENABLE) return;
+  register_shutdown_hook(profile_write);
+  sampling = 1;
+}
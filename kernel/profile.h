@@ -0,0 +1,18 @@
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+#include "util/types.h"
+#include "elf.h"
+
+// the ELF images whose symbols name the samples
+#define PROFILE_KERNEL 0
+#define PROFILE_USER 1
+
+// record the pc interrupted by a timer tick. called by the M-mode timer handler.
+void profile_sample(uint64 hartid, uint64 pc, int from_kernel);
+// keep the symbols of an ELF image (PROFILE_KERNEL or PROFILE_USER) to name the samples
+void profile_load_symbols(int image, elf_ctx *ctx);
+// start sampling, and have the profile written to PROFILE_PATH at shutdown
+void profile_init(void);
+
+#endif
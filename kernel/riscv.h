@@ -11,6 +11,8 @@
 #define MSTATUS_MPP_U (0L << 11)    // user mode (u-mode)
 #define MSTATUS_MIE (1L << 3)       // machine-mode interrupt enable
 #define MSTATUS_MPIE (1L << 7)      // preserve MIE bit
+#define MSTATUS_VS (3L << 9)        // vector unit state (off/initial/clean/dirty)
+#define MSTATUS_VS_INITIAL (1L << 9)
 
 // values of mcause, the Machine Cause register
 #define IRQ_S_EXT 9                 // s-mode external interrupt
@@ -52,6 +54,11 @@
 #define CAUSE_LOAD_PAGE_FAULT 0xd      // Load page fault
 #define CAUSE_STORE_PAGE_FAULT 0xf     // Store/AMO page fault
 
+// interrupts (mcause/scause with the top bit set)
+#define CAUSE_MTIMER 0x8000000000000007       // M-mode timer interrupt
+#define CAUSE_MTIMER_S_TRAP 0x8000000000000001  // timer tick forwarded to S-mode as SSIP
+#define CAUSE_SEXT 0x8000000000000009           // S-mode external interrupt, from the PLIC
+
 // fields of sstatus, the Supervisor mode Status register
 #define SSTATUS_SPP (1L << 8)   // Previous mode, 1=Supervisor, 0=User
 #define SSTATUS_SPIE (1L << 5)  // Supervisor Previous Interrupt Enable
@@ -59,7 +66,20 @@
 #define SSTATUS_SIE (1L << 1)   // Supervisor Interrupt Enable
 #define SSTATUS_UIE (1L << 0)   // User Interrupt Enable
 #define SSTATUS_SUM 0x00040000
-#define SSTATUS_FS 0x00006000
+#define SSTATUS_FS 0x00006000  // floating-point unit state
+#define SSTATUS_FS_OFF 0x00000000
+#define SSTATUS_FS_INITIAL 0x00002000
+#define SSTATUS_FS_CLEAN 0x00004000
+#define SSTATUS_FS_DIRTY 0x00006000
+#define SSTATUS_VS (3L << 9)  // vector unit state
+#define SSTATUS_VS_OFF (0L << 9)
+#define SSTATUS_VS_INITIAL (1L << 9)
+#define SSTATUS_VS_CLEAN (2L << 9)
+#define SSTATUS_VS_DIRTY (3L << 9)
+
+// Supervisor Interrupt Pending
+#define SIP_SSIP (1L << 1)  // software
+#define SIP_SEIP (1L << 9)  // external
 
 // Supervisor Interrupt Enable
 #define SIE_SEIE (1L << 9)  // external
@@ -71,6 +91,13 @@
 #define MIE_MTIE (1L << 7)   // timer
 #define MIE_MSIE (1L << 3)   // software
 
+// memory-mapped registers of the CLINT (core local interruptor) at base
+#define CLINT_MTIMECMP(base, hartid) ((base) + 0x4000 + 8 * (hartid))
+#define CLINT_MTIME(base) ((base) + 0xBFF8)  // cycles since boot
+
+#define PGSIZE 4096  // bytes per page
+#define PGSHIFT 12   // offset bits within a page
+
 #define read_const_csr(reg)              \
   ({                                     \
     unsigned long __tmp;                 \
@@ -105,12 +132,32 @@ static inline int supports_extension(char ext) {
     __tmp;                                                            \
   })
 
+// fields of mcounteren, which counters the lower privilege modes may read
+#define COUNTEREN_CY (1L << 0)  // cycle
+#define COUNTEREN_TM (1L << 1)  // time
+#define COUNTEREN_IR (1L << 2)  // instret
+
+// read the cycle counter. S-mode needs COUNTEREN_CY in mcounteren (see m_start()).
+static inline uint64 read_cycle(void) { return read_csr(cycle); }
+
 // enable device interrupts
 static inline void intr_on(void) { write_csr(sstatus, read_csr(sstatus) | SSTATUS_SIE); }
 
 // disable device interrupts
 static inline void intr_off(void) { write_csr(sstatus, read_csr(sstatus) & ~SSTATUS_SIE); }
 
+// disable device interrupts, returning whether they were enabled, for intr_restore()
+static inline int intr_save(void) {
+  uint64 x;
+  asm volatile("csrrc %0, sstatus, %1" : "=r"(x) : "i"(SSTATUS_SIE) : "memory");
+  return (x & SSTATUS_SIE) != 0;
+}
+
+// enable device interrupts again if they were before intr_save()
+static inline void intr_restore(int enabled) {
+  if (enabled) intr_on();
+}
+
 // are device interrupts enabled?
 static inline int is_intr_enable(void) {
   //  uint64 x = r_sstatus();
@@ -0,0 +1,68 @@
+/*
+ * named shared memory regions, for processes to exchange data without a kernel copy (see
+ * the rings of user/uring.c). regions are carved from [shm_start, shm_end) of the memory
+ * layout, and never given back: a region whose last user closed it stays, with its
+ * contents, for the next one to open the name.
+ *
+ * lab1 runs without paging, where every process sees all of the user memory at the same
+ * addresses, so "mapping" a region is handing out its address.
+ */
+
+#include "shm.h"
+#include "riscv.h"
+#include "config.h"
+#include "pmm.h"
+#include "process.h"
+#include "trace.h"
+#include "util/functions.h"
+#include "util/string.h"
+
+#include "spike_interface/spike_utils.h"
+
+typedef struct shm_region_t {
+  char name[SHM_NAME_MAX];
+  uint64 addr, size;
+  int refs;
+} shm_region;
+
+static shm_region shm_regions[SHM_MAX_REGIONS];
+static int shm_nregions = 0;
+// start of the unused part of the shared memory
+static uint64 shm_next = 0;
+
+uint64 shm_open(process *p, const char *name, uint64 size) {
+  size_t len = strlen(name);
+  if (len == 0 || len >= SHM_NAME_MAX) return -1;
+
+  for (int i = 0; i < shm_nregions; i++) {
+    shm_region *r = &shm_regions[i];
+    if (strcmp(r->name, name) != 0) continue;
+    if (size > r->size) return -1;
+    r->refs++;
+    return r->addr;
+  }
+
+  if (!shm_next) shm_next = g_mem_layout.shm_start;
+  size = ROUNDUP(size, PGSIZE);
+  if (shm_nregions == SHM_MAX_REGIONS || size == 0 || size > g_mem_layout.shm_end - shm_next)
+    return -1;
+
+  shm_region *r = &shm_regions[shm_nregions++];
+  strcpy(r->name, name);
+  r->addr = shm_next;
+  r->size = size;
+  r->refs = 1;
+  shm_next += size;
+  memset((void *)r->addr, 0, size);
+  trace("shm region at %lx, %ld bytes", r->addr, size);
+  return r->addr;
+}
+
+int shm_close(process *p, uint64 addr) {
+  for (int i = 0; i < shm_nregions; i++)
+    if (shm_regions[i].addr == addr && shm_regions[i].refs > 0) {
+      shm_regions[i].refs--;
+      return 0;
+    }
+  return -1;
+}
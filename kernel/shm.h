@@ -0,0 +1,15 @@
+#ifndef _SHM_H_
+#define _SHM_H_
+
+#include "util/types.h"
+
+#define SHM_NAME_MAX 32
+
+struct process_t;
+// the address of the shared memory region called name, created (zero-filled, with at least
+// size bytes) if it does not exist yet. returns -1 if it can not be found nor created.
+uint64 shm_open(struct process_t *p, const char *name, uint64 size);
+// drop the reference of p to the region at addr
+int shm_close(struct process_t *p, uint64 addr);
+
+#endif
@@ -3,9 +3,20 @@
  */
 
 #include "riscv.h"
+#include "config.h"
 #include "process.h"
 #include "strap.h"
 #include "syscall.h"
+#include "trace.h"
+#include "fp.h"
+#include "vector.h"
+#include "timer.h"
+#include "idle.h"
+#include "preempt.h"
+#include "ustack.h"
+#include "kinfo.h"
+#include "plic.h"
+#include "util/string.h"
 
 #include "spike_interface/spike_utils.h"
 
@@ -22,33 +33,239 @@ static void handle_syscall(trapframe *tf) {
   // kernel/syscall.c) to conduct real operations of the kernel side for a syscall.
   // IMPORTANT: return value should be returned to user app, or else, you will encounter
   // problems in later experiments!
+  trace_begin("syscall %ld (%lx, %lx, %lx)", tf->regs.a0, tf->regs.a1, tf->regs.a2, tf->regs.a3);
   tf->regs.a0 = do_syscall(tf->regs.a0,tf->regs.a1,tf->regs.a2,tf->regs.a3,tf->regs.a4,tf->regs.a5,tf->regs.a6,tf->regs.a7);
+  trace_end("syscall");
 
 }
 
+uint64 g_ticks = 0;
+
+//
+// the timer tick, which the M-mode timer handler (kernel/machine/mtrap.c) forwards to us
+// as a software interrupt. the tick count may jump by many ticks, as the kernel runs
+// tickless unless TIMER_PERIODIC.
+//
+static void handle_mtimer_trap() {
+  g_ticks = timer_now();
+  g_kstats.timer_irqs++;
+  // clear the pending software interrupt, or we would take it again after sret
+  write_csr(sip, read_csr(sip) & ~SIP_SSIP);
+  // run the expired timers. timer_run() is defined in kernel/timer.c
+  timer_run();
+}
+
+//
+// the interrupts of the devices, which the PLIC passes on as external interrupts.
+// plic_handle() is defined in kernel/plic.c, and runs the handlers the drivers registered.
+//
+static void handle_sext_trap(void) { plic_handle(); }
+
+//
+// wait in the kernel for the next timer tick. the caller turns interrupts off, so that the
+// tick it waits for is not taken by kernel_trap_handler() before we get here. wfi still
+// returns once the tick is pending, and we count it here instead of trapping.
+// idle_wait() is defined in kernel/idle.c
+//
+void wait_tick(void) {
+  while (!(read_csr(sip) & SIP_SSIP)) {
+    idle_wait();
+    // device interrupts that arrive meanwhile are served here, as well
+    if (read_csr(sip) & SIP_SEIP) handle_sext_trap();
+  }
+  handle_mtimer_trap();
+}
+
+int g_preempt_count[NCPU];
+
+void preempt_point(void) {
+  if (g_preempt_count[read_tp()] || is_intr_enable()) return;
+  if (read_csr(sip) & read_csr(sie)) {
+    // the pending interrupts are taken right after intr_on(), by kernel_trap_handler()
+    intr_on();
+    intr_off();
+  }
+}
+
+//
+// kernel/strap_vector.S will pass control to kernel_trap_handler, when a trap happens
+// while the kernel runs. interrupts are the traps we expect here, and the access faults of
+// syscalls that touch the user stack below where it has grown (e.g., read() into a large
+// local array): the stack grows, and the access is retried. any other exception of the
+// kernel is a bug.
+//
+// smode_kernel_vector saves no vector registers, and the interrupted code may be in the
+// middle of a vector memcpy() or the like: the handler runs the scalar versions of the
+// string routines (see util/string.c). the HTIF locks, which the interrupted code may hold,
+// are taken with interrupts off (see spike_interface/atomic.h), so the handler may print.
+//
+void kernel_trap_handler(void) {
+  uint64 cause = read_csr(scause);
+  int vec = string_vector_enabled();
+  string_disable_vector();
+
+  // ustack_handle_fault() is defined in kernel/ustack.c
+  if ((cause == CAUSE_LOAD_ACCESS || cause == CAUSE_STORE_ACCESS) && current &&
+      ustack_handle_fault(current, read_csr(stval))) {
+    // the stack has grown over the faulting address, retry the access
+  } else if (cause == CAUSE_MTIMER_S_TRAP || cause == CAUSE_SEXT) {
+    // the interrupted kernel code may not be preempted by what the handler does
+    preempt_disable();
+    trace_begin("kernel trap %lx sepc %lx", cause, read_csr(sepc));
+    if (cause == CAUSE_SEXT)
+      handle_sext_trap();
+    else
+      handle_mtimer_trap();
+    trace_end("kernel trap");
+    preempt_enable();
+  } else {
+    trace("unexpected kernel trap %lx stval %lx", cause, read_csr(stval));
+    sprint("kernel_trap_handler(): unexpected scause %p\n", cause);
+    sprint("            sepc=%p stval=%p\n", read_csr(sepc), read_csr(stval));
+    panic("unexpected exception happened in the kernel.\n");
+  }
+
+  if (vec) string_enable_vector();
+}
+
+//
+// smode_kernel_vector (kernel/strap_vector.S) comes here, on stack0, when the kernel stack
+// has run into its guard (KSTACK_GUARD in kernel/config.h)
+//
+void kernel_stack_overflow_panic(void) {
+  sprint("kernel stack overflow: sepc=%p stval=%p\n", read_csr(sepc), read_csr(stval));
+  panic("the kernel stack of %d KB is exhausted.\n", KSTACK_SIZE >> 10);
+}
+
+// major opcodes (bits 6:0) of the instructions that use the FP or vector registers
+#define OPC_LOAD_FP 0x07
+#define OPC_STORE_FP 0x27
+#define OPC_MADD 0x43
+#define OPC_MSUB 0x47
+#define OPC_NMSUB 0x4b
+#define OPC_NMADD 0x4f
+#define OPC_OP_FP 0x53
+#define OPC_OP_V 0x57
+#define OPC_SYSTEM 0x73
+
+// the instruction p trapped on: stval, if the hart reports it there, else read from the
+// user memory, which the kernel accesses directly in lab1 (Bare mode)
+static uint32 trapped_insn(process *p) {
+  uint64 insn = read_csr(stval);
+  if (insn) return insn;
+  uint16 *pc = (uint16 *)p->trapframe->epc;
+  insn = pc[0];
+  if ((insn & 3) == 3) insn |= (uint32)pc[1] << 16;
+  return insn;
+}
+
+//
+// an illegal-instruction trap of p may be its use of the FP or vector unit while the unit
+// is Off for it. decode the instruction to tell which unit it needs: the vector loads and
+// stores share the LOAD-FP and STORE-FP opcodes with the FP ones, and differ in the width
+// field, and the vector FP instructions need both units. returns 1 if a unit was loaded
+// for p, which retries the instruction, or 0 if the instruction is illegal after all.
+//
+static int handle_illegal_insn(process *p) {
+  uint32 insn = trapped_insn(p);
+  uint32 funct3 = (insn >> 12) & 7;
+  int fp = 0, vec = 0;
+
+  if ((insn & 3) != 3) {
+    // compressed: c.fld and c.fsd in quadrant 0, c.fldsp and c.fsdsp in quadrant 2, all
+    // with funct3 (bits 15:13) x01
+    fp = (insn & 3) != 1 && ((insn >> 13) & 3) == 1;
+  } else {
+    switch (insn & 0x7f) {
+      case OPC_LOAD_FP:
+      case OPC_STORE_FP:
+        // widths 1-4 are h, s, d and q. 0 and 5-7 are the element widths of vectors.
+        if (funct3 >= 1 && funct3 <= 4)
+          fp = 1;
+        else
+          vec = 1;
+        break;
+      case OPC_MADD:
+      case OPC_MSUB:
+      case OPC_NMSUB:
+      case OPC_NMADD:
+      case OPC_OP_FP:
+        fp = 1;
+        break;
+      case OPC_OP_V:
+        vec = 1;
+        // OPFVV and OPFVF, the vector FP instructions, trap while FS is Off as well
+        fp = funct3 == 1 || funct3 == 5;
+        break;
+      case OPC_SYSTEM:
+        // the CSR instructions: funct3 other than 0 and 4
+        if (funct3 & 3) {
+          uint32 csr = insn >> 20;
+          // fflags, frm and fcsr
+          fp = csr >= 0x001 && csr <= 0x003;
+          // vstart, vxsat, vxrm, vcsr, and the read-only vl, vtype and vlenb
+          vec = (csr >= 0x008 && csr <= 0x00a) || csr == 0x00f || (csr >= 0xc20 && csr <= 0xc22);
+        }
+        break;
+    }
+  }
+
+  // fp_handle_trap() and vec_handle_trap(), defined in kernel/fp.c and kernel/vector.c,
+  // return 0 if the unit is on for p already
+  int handled = 0;
+  if (fp) handled |= fp_handle_trap(p);
+  if (vec) handled |= vec_handle_trap(p);
+  return handled;
+}
+
 //
-// kernel/smode_trap.S will pass control to smode_trap_handler, when a trap happens
-// in S-mode.
+// kernel/strap_vector.S will pass control to smode_trap_handler, when a trap happens
+// in U-mode.
 //
 void smode_trap_handler(void) {
-  // make sure we are in User mode before entering the trap handling.
-  // we will consider other previous case in lab1_3 (interrupt).
+  // make sure we are in User mode before entering the trap handling. traps of the kernel
+  // itself go to smode_kernel_vector.
   if ((read_csr(sstatus) & SSTATUS_SPP) != 0) panic("usertrap: not from user mode");
+  write_csr(stvec, (uint64)smode_kernel_vector);
 
   assert(current);
+  // the kernel may use the vector unit if no process owns it. vec_kernel_enter(), defined in
+  // kernel/vector.c, also notes whether V was Off for current, for handle_illegal_insn().
+  vec_kernel_enter();
   // save user process counter.
   current->trapframe->epc = read_csr(sepc);
+  trace_begin("trap %lx sepc %lx", read_csr(scause), current->trapframe->epc);
 
   // if the cause of trap is syscall from user application.
   // read_csr() and CAUSE_USER_ECALL are macros defined in kernel/riscv.h
-  if (read_csr(scause) == CAUSE_USER_ECALL) {
+  uint64 cause = read_csr(scause);
+  // published on the kinfo page, see kernel/kinfo.c
+  g_kstats.traps++;
+  if (cause == CAUSE_USER_ECALL) {
+    g_kstats.syscalls++;
+    // a syscall may take long, e.g., when it moves a lot of data: let interrupts in
+    intr_on();
     handle_syscall(current->trapframe);
+    intr_off();
+  } else if (cause == CAUSE_MTIMER_S_TRAP) {
+    handle_mtimer_trap();
+  } else if (cause == CAUSE_SEXT) {
+    handle_sext_trap();
+  } else if ((cause == CAUSE_LOAD_ACCESS || cause == CAUSE_STORE_ACCESS) &&
+             ustack_handle_fault(current, read_csr(stval))) {
+    // the stack has grown over the faulting address, retry the access.
+    // ustack_handle_fault() is defined in kernel/ustack.c
+  } else if (cause == CAUSE_ILLEGAL_INSTRUCTION && handle_illegal_insn(current)) {
+    // the FP or vector registers the instruction uses are loaded now, retry it
   } else {
+    // including the page faults, which can not happen in the Bare mode of lab1
+    trace("unexpected trap %lx stval %lx", cause, read_csr(stval));
     sprint("smode_trap_handler(): unexpected scause %p\n", read_csr(scause));
     sprint("            sepc=%p stval=%p\n", read_csr(sepc), read_csr(stval));
     panic( "unexpected exception happened.\n" );
   }
 
+  trace_end("trap");
   // continue (come back to) the execution of current process.
   switch_to(current);
 }
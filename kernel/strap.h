@@ -1,6 +1,18 @@
 #ifndef _STRAP_H_
 #define _STRAP_H_
 
+#include "util/types.h"
+
 void smode_trap_handler(void);
+void kernel_trap_handler(void);
+void kernel_stack_overflow_panic(void);
+
+// the trap vector while the kernel runs, defined in kernel/strap_vector.S
+extern char smode_kernel_vector[];
+
+// number of timer ticks since boot
+extern uint64 g_ticks;
+// wait for the next timer tick, from the kernel
+void wait_tick(void);
 
 #endif
@@ -10,6 +10,13 @@
 #include "string.h"
 #include "process.h"
 #include "util/functions.h"
+#include "trace.h"
+#include "hpm.h"
+#include "futex.h"
+#include "shm.h"
+#include "pipe.h"
+#include "console.h"
+#include "timer.h"
 
 #include "spike_interface/spike_utils.h"
 
@@ -31,6 +38,167 @@ ssize_t sys_user_exit(uint64 code) {
   shutdown(code);
 }
 
+//
+// implement the SYS_user_trace_dump syscall: save the kernel trace rings in a host file,
+// to be decoded by tools/trace_decode.py
+//
+ssize_t sys_user_trace_dump(const char* path) {
+  return trace_dump_file(path);
+}
+
+//
+// implement the SYS_user_perf_open syscall: count a (raw, implementation defined) hardware
+// event on a free performance counter. returns the counter number, for the user to read
+// it with rdhpmcounter, or -1.
+//
+ssize_t sys_user_perf_open(uint64 event) {
+  return hpm_open(current, event);
+}
+
+//
+// implement the SYS_user_perf_close syscall
+//
+ssize_t sys_user_perf_close(int counter) {
+  return hpm_close(current, counter);
+}
+
+//
+// implement the SYS_user_perf_read syscall: the count of counter, stored in *value
+//
+ssize_t sys_user_perf_read(int counter, uint64* value) {
+  return hpm_read(current, counter, value);
+}
+
+//
+// implement the SYS_user_yield syscall. in lab1, the only process is given the cpu back
+// right away.
+//
+ssize_t sys_user_yield() {
+  return 0;
+}
+
+// host files opened by the user, by descriptor. lab1 keeps them for its only process.
+#define USER_MAX_FILES 8
+static spike_file_t* user_files[USER_MAX_FILES];
+
+static spike_file_t* user_file(int fd) {
+  return fd >= 0 && fd < USER_MAX_FILES ? user_files[fd] : NULL;
+}
+
+//
+// implement the SYS_user_file_open syscall: open the host file at path for reading.
+// returns its descriptor, or -1.
+//
+ssize_t sys_user_file_open(const char* path) {
+  for (int fd = 0; fd < USER_MAX_FILES; fd++) {
+    if (user_files[fd]) continue;
+    spike_file_t* f = spike_file_open(path, O_RDONLY, 0);
+    if (IS_ERR_VALUE(f)) return -1;
+    user_files[fd] = f;
+    return fd;
+  }
+  return -1;
+}
+
+//
+// implement the SYS_user_file_pread syscall: read up to n bytes at offset off of the file
+// fd into buf. returns the bytes read, or -1.
+//
+ssize_t sys_user_file_pread(int fd, char* buf, uint64 n, uint64 off) {
+  spike_file_t* f = user_file(fd);
+  if (!f) return -1;
+  return spike_file_pread(f, buf, n, off);
+}
+
+//
+// implement the SYS_user_file_close syscall
+//
+ssize_t sys_user_file_close(int fd) {
+  spike_file_t* f = user_file(fd);
+  if (!f) return -1;
+  user_files[fd] = NULL;
+  // f is in no spike fd table, so spike_file_close() would leave the host file open: drop
+  // the two references after which spike_file_decref() closes it
+  spike_file_decref(f);
+  spike_file_decref(f);
+  return 0;
+}
+
+//
+// implement the SYS_user_futex_wait syscall: sleep while *addr == expected, for at most
+// timeout timer ticks (0: no limit). returns 0 when woken by SYS_user_futex_wake, else -1.
+//
+ssize_t sys_user_futex_wait(uint64 addr, uint32 expected, uint64 timeout) {
+  return futex_wait(current, addr, expected, timeout);
+}
+
+//
+// implement the SYS_user_futex_wake syscall: wake up to n sleepers on addr
+//
+ssize_t sys_user_futex_wake(uint64 addr, int n) {
+  return futex_wake(addr, n);
+}
+
+//
+// implement the SYS_user_shm_open syscall: the address of the shared memory region called
+// name, created with size bytes if needed, or -1
+//
+ssize_t sys_user_shm_open(const char* name, uint64 size) {
+  return shm_open(current, name, size);
+}
+
+//
+// implement the SYS_user_shm_close syscall
+//
+ssize_t sys_user_shm_close(uint64 addr) {
+  return shm_close(current, addr);
+}
+
+//
+// implement the SYS_user_pipe syscall: fds[0] gets the read end, fds[1] the write end
+//
+ssize_t sys_user_pipe(int* fds) {
+  return pipe_create(current, fds);
+}
+
+//
+// implement the SYS_user_read and SYS_user_write syscalls, on pipes and the console
+//
+ssize_t sys_user_read(int fd, char* buf, uint64 n) {
+  if (fd >= 0 && fd < CONSOLE_NFDS) return console_read(buf, n);
+  return pipe_read(current, fd, buf, n);
+}
+
+ssize_t sys_user_write(int fd, const char* buf, uint64 n) {
+  if (fd >= 0 && fd < CONSOLE_NFDS) return console_write(buf, n);
+  return pipe_write(current, fd, buf, n);
+}
+
+//
+// implement the SYS_user_close syscall
+//
+ssize_t sys_user_close(int fd) {
+  return pipe_close(current, fd);
+}
+
+//
+// implement the SYS_user_splice syscall: append up to n bytes from the pipe fd to the host
+// file at path
+//
+ssize_t sys_user_splice(int fd, const char* path, uint64 n) {
+  return pipe_splice(current, fd, path, n);
+}
+
+//
+// implement the SYS_user_nanosleep syscall: sleep for at least ns nanoseconds, rounded up
+// to whole timer ticks
+//
+ssize_t sys_user_nanosleep(uint64 ns) {
+  uint64 ns_per_tick = 1000000000 / TIMER_HZ;
+  timer_sleep((ns + ns_per_tick - 1) / ns_per_tick);
+  return 0;
+}
+
 //
 // [a0]: the syscall number; [a1] ... [a7]: arguments to the syscalls.
 // returns the code of success, (e.g., 0 means success, fail for otherwise)
@@ -41,6 +209,42 @@ long do_syscall(long a0, long a1, long a2, long a3, long a4, long a5, long a6, l
       return sys_user_print((const char*)a1, a2);
     case SYS_user_exit:
       return sys_user_exit(a1);
+    case SYS_user_trace_dump:
+      return sys_user_trace_dump((const char*)a1);
+    case SYS_user_perf_open:
+      return sys_user_perf_open(a1);
+    case SYS_user_perf_close:
+      return sys_user_perf_close(a1);
+    case SYS_user_perf_read:
+      return sys_user_perf_read(a1, (uint64*)a2);
+    case SYS_user_yield:
+      return sys_user_yield();
+    case SYS_user_file_open:
+      return sys_user_file_open((const char*)a1);
+    case SYS_user_file_pread:
+      return sys_user_file_pread(a1, (char*)a2, a3, a4);
+    case SYS_user_file_close:
+      return sys_user_file_close(a1);
+    case SYS_user_futex_wait:
+      return sys_user_futex_wait(a1, a2, a3);
+    case SYS_user_futex_wake:
+      return sys_user_futex_wake(a1, a2);
+    case SYS_user_shm_open:
+      return sys_user_shm_open((const char*)a1, a2);
+    case SYS_user_shm_close:
+      return sys_user_shm_close(a1);
+    case SYS_user_pipe:
+      return sys_user_pipe((int*)a1);
+    case SYS_user_read:
+      return sys_user_read(a1, (char*)a2, a3);
+    case SYS_user_write:
+      return sys_user_write(a1, (const char*)a2, a3);
+    case SYS_user_close:
+      return sys_user_close(a1);
+    case SYS_user_splice:
+      return sys_user_splice(a1, (const char*)a2, a3);
+    case SYS_user_nanosleep:
+      return sys_user_nanosleep(a1);
     default:
       panic("Unknown syscall %ld \n", a0);
   }
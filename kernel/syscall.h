@@ -8,6 +8,24 @@
 #define SYS_user_base 64
 #define SYS_user_print (SYS_user_base + 0)
 #define SYS_user_exit (SYS_user_base + 1)
+#define SYS_user_trace_dump (SYS_user_base + 2)
+#define SYS_user_perf_open (SYS_user_base + 3)
+#define SYS_user_perf_close (SYS_user_base + 4)
+#define SYS_user_perf_read (SYS_user_base + 5)
+#define SYS_user_yield (SYS_user_base + 6)
+#define SYS_user_file_open (SYS_user_base + 7)
+#define SYS_user_file_pread (SYS_user_base + 8)
+#define SYS_user_file_close (SYS_user_base + 9)
+#define SYS_user_futex_wait (SYS_user_base + 10)
+#define SYS_user_futex_wake (SYS_user_base + 11)
+#define SYS_user_shm_open (SYS_user_base + 12)
+#define SYS_user_shm_close (SYS_user_base + 13)
+#define SYS_user_pipe (SYS_user_base + 14)
+#define SYS_user_read (SYS_user_base + 15)
+#define SYS_user_write (SYS_user_base + 16)
+#define SYS_user_close (SYS_user_base + 17)
+#define SYS_user_splice (SYS_user_base + 18)
+#define SYS_user_nanosleep (SYS_user_base + 19)
 
 long do_syscall(long a0, long a1, long a2, long a3, long a4, long a5, long a6, long a7);
 
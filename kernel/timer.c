@@ -0,0 +1,196 @@
+/*
+ * hierarchical timing wheels, one per hart, after Varghese and Lauck. a timer is put in
+ * the slot of the lowest level that can tell its expiry apart from the current tick: level
+ * 0 for the next TW_SLOTS ticks, level 1 for the next TW_SLOTS^2, and so on. when the
+ * lower levels of the tick count wrap around, the timers of the next slot of a higher level
+ * are cascaded into lower levels, until they reach level 0 and fire. insert and cancel are
+ * O(1), and a tick touches only one slot per level.
+ *
+ * with bitmaps of the non-empty slots, the next tick at which anything happens (a timer
+ * fires, or a slot cascades) is found without walking the slots. unless TIMER_PERIODIC,
+ * the hardware timer is armed for just that tick, and the kernel runs tickless.
+ */
+
+#include "timer.h"
+#include "riscv.h"
+#include "mcall.h"
+#include "strap.h"
+#include "trace.h"
+
+#include "spike_interface/spike_utils.h"
+
+static timer_wheel wheels[NCPU];
+
+static struct {
+  uint64 added, cancelled, fired, cascaded, runs;
+  // from the timer interrupt in M-mode to timer_run(), in mtime units
+  uint64 latency_sum, latency_max;
+} timer_stats;
+
+uint64 timer_now(void) { return (read_csr(time) - g_timer_base) / g_timer_interval; }
+
+static uint64 level_shift(int level) { return TW_BITS * level; }
+
+static void slot_insert(timer_wheel *w, ktimer *t, uint64 when) {
+  // the expiry may be beyond the reach of the wheel: park the timer as far as it goes,
+  // to be placed again when its slot cascades
+  uint64 reach = (1ULL << level_shift(TW_LEVELS)) - 1;
+  if (when - w->now > reach) when = w->now + reach;
+
+  int level = 0;
+  while (level < TW_LEVELS - 1 &&
+         (when >> level_shift(level + 1)) != (w->now >> level_shift(level + 1)))
+    level++;
+  int slot = (when >> level_shift(level)) & (TW_SLOTS - 1);
+
+  t->level = level;
+  t->slot = slot;
+  ktimer **head = &w->slots[level][slot];
+  t->next = *head;
+  if (t->next) t->next->pprev = &t->next;
+  t->pprev = head;
+  *head = t;
+  w->pending[level] |= 1ULL << slot;
+}
+
+static void slot_remove(timer_wheel *w, ktimer *t) {
+  *t->pprev = t->next;
+  if (t->next) t->next->pprev = t->pprev;
+  t->pprev = 0;
+  if (!w->slots[t->level][t->slot]) w->pending[t->level] &= ~(1ULL << t->slot);
+}
+
+//
+// the next tick, after w->now, at which a timer fires or a slot cascades: the start of the
+// first non-empty slot of each level. -1 if the wheel is empty.
+//
+static uint64 next_event(timer_wheel *w) {
+  uint64 next = -1;
+  for (int level = 0; level < TW_LEVELS; level++) {
+    uint64 mask = w->pending[level];
+    if (!mask) continue;
+    uint64 shift = level_shift(level);
+    int cur = (w->now >> shift) & (TW_SLOTS - 1);
+    // rotate the slots after the current one down to bit 0
+    int rot = (cur + 1) & (TW_SLOTS - 1);
+    uint64 ahead = rot ? (mask >> rot) | (mask << (TW_SLOTS - rot)) : mask;
+    uint64 event = ((w->now >> shift) + __builtin_ctzll(ahead) + 1) << shift;
+    if (event < next) next = event;
+  }
+  return next;
+}
+
+// set the hardware timer of the hart for the next event of w, if it changed
+static void timer_program(timer_wheel *w) {
+  if (TIMER_PERIODIC) return;
+  uint64 next = next_event(w);
+  if (next == w->armed) return;
+  w->armed = next;
+  // served by handle_mcall() in kernel/machine/mtrap.c
+  mcall(MCALL_TIMER_SET, next, 0, 0);
+}
+
+//
+// the wheel is also changed by timer_run() in the timer interrupt, so timer_add() and
+// timer_cancel() keep interrupts off.
+//
+void timer_add(ktimer *t, uint64 expires) {
+  int intr = intr_save();
+  timer_wheel *w = &wheels[read_tp()];
+  if (t->pprev) slot_remove(t->wheel, t);
+  t->expires = expires;
+  t->wheel = w;
+  // a timer already due fires on the next tick processed
+  slot_insert(w, t, expires > w->now ? expires : w->now + 1);
+  timer_stats.added++;
+  timer_program(w);
+  intr_restore(intr);
+}
+
+void timer_cancel(ktimer *t) {
+  int intr = intr_save();
+  if (t->pprev) {
+    slot_remove(t->wheel, t);
+    timer_stats.cancelled++;
+  }
+  intr_restore(intr);
+}
+
+// move the timers of a slot of level to lower levels, now that w->now reached the slot
+static void cascade(timer_wheel *w, int level) {
+  int slot = (w->now >> level_shift(level)) & (TW_SLOTS - 1);
+  ktimer *t;
+  while ((t = w->slots[level][slot])) {
+    slot_remove(w, t);
+    slot_insert(w, t, t->expires > w->now ? t->expires : w->now);
+    timer_stats.cascaded++;
+  }
+}
+
+// process tick w->now: cascade the levels that wrapped around, from the top, then fire
+static void run_tick(timer_wheel *w) {
+  int top = 0;
+  while (top + 1 < TW_LEVELS && (w->now & ((1ULL << level_shift(top + 1)) - 1)) == 0) top++;
+  for (int level = top; level > 0; level--) cascade(w, level);
+
+  int slot = w->now & (TW_SLOTS - 1);
+  ktimer *t;
+  while ((t = w->slots[0][slot])) {
+    slot_remove(w, t);
+    timer_stats.fired++;
+    t->fn(t);
+  }
+}
+
+void timer_run(void) {
+  uint64 hart = read_tp();
+  timer_wheel *w = &wheels[hart];
+  uint64 now = timer_now();
+
+  // how long the kernel kept the interrupt waiting
+  uint64 latency = read_csr(time) - g_timer_raised[hart];
+  timer_stats.runs++;
+  timer_stats.latency_sum += latency;
+  if (latency > timer_stats.latency_max) timer_stats.latency_max = latency;
+
+  // jump from one event to the next, skipping the ticks where nothing happens
+  while (w->now < now) {
+    uint64 next = next_event(w);
+    w->now = next < now ? next : now;
+    run_tick(w);
+  }
+  // the hardware timer is spent, see handle_timer() in kernel/machine/mtrap.c
+  w->armed = -1;
+  timer_program(w);
+}
+
+static void sleep_done(ktimer *t) { *(volatile int *)t->arg = 1; }
+
+void timer_sleep(uint64 ticks) {
+  volatile int done = 0;
+  ktimer t = {.fn = sleep_done, .arg = (void *)&done};
+  trace_begin("sleep %ld ticks", ticks);
+  // see wait_tick() in kernel/strap.c
+  int intr = intr_save();
+  timer_add(&t, timer_now() + ticks);
+  while (!done) wait_tick();
+  intr_restore(intr);
+  trace_end("sleep");
+}
+
+static void timer_report(int code, int panic) {
+  sprint("timers: %ld added, %ld cancelled, %ld fired, %ld cascaded, %ld timer interrupts\n",
+         timer_stats.added, timer_stats.cancelled, timer_stats.fired, timer_stats.cascaded,
+         timer_stats.runs);
+  if (timer_stats.runs)
+    sprint("timer interrupt latency: max %ld, avg %ld mtime units\n", timer_stats.latency_max,
+           timer_stats.latency_sum / timer_stats.runs);
+}
+
+void timer_init(void) {
+  for (int i = 0; i < NCPU; i++) {
+    wheels[i].now = timer_now();
+    wheels[i].armed = -1;
+  }
+  register_shutdown_hook(timer_report);
+}
@@ -0,0 +1,54 @@
+#ifndef _TIMER_H_
+#define _TIMER_H_
+
+#include "util/types.h"
+#include "config.h"
+
+// the timing wheel of a hart: TW_LEVELS levels of TW_SLOTS slots. a slot of level l spans
+// TW_SLOTS^l ticks, so the wheel reaches 2^(TW_BITS * TW_LEVELS) ticks ahead.
+#define TW_BITS 6
+#define TW_SLOTS (1 << TW_BITS)
+#define TW_LEVELS 4
+
+// without the profiler, which samples on every tick, the timer interrupts only when a
+// ktimer expires
+#define TIMER_PERIODIC (!TIMER_TICKLESS || PROFILE_ENABLE)
+
+// a timer, to be zero-initialized. fn(t) runs in the timer interrupt once the tick count
+// reaches expires.
+typedef struct ktimer_t {
+  struct ktimer_t *next, **pprev;  // in the slot list, pprev is NULL if not pending
+  uint64 expires;
+  void (*fn)(struct ktimer_t *t);
+  void *arg;
+  struct timer_wheel_t *wheel;
+  int level, slot;  // where t is pending
+} ktimer;
+
+typedef struct timer_wheel_t {
+  uint64 now;                    // the last tick processed
+  uint64 armed;                  // the tick the hardware timer is set for, -1 if none
+  uint64 pending[TW_LEVELS];     // bit s set if slot s of the level holds timers
+  ktimer *slots[TW_LEVELS][TW_SLOTS];
+} timer_wheel;
+
+// the mtime of tick 0, and the mtime units per tick. set by timerinit() in
+// kernel/machine/mtrap.c
+extern uint64 g_timer_base, g_timer_interval;
+// mtime when M-mode last forwarded a timer interrupt to the S-mode kernel, per hart
+extern uint64 g_timer_raised[NCPU];
+
+// the current tick, from the time CSR
+uint64 timer_now(void);
+// (re)arm t on the wheel of the current hart, to expire at tick expires. O(1).
+void timer_add(ktimer *t, uint64 expires);
+// disarm t, if pending. O(1).
+void timer_cancel(ktimer *t);
+// process the ticks up to now: run the expired timers, and arm the hardware timer for
+// the next one. called on every timer interrupt.
+void timer_run(void);
+// sleep in the kernel for the given number of ticks
+void timer_sleep(uint64 ticks);
+void timer_init(void);
+
+#endif
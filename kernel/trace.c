@@ -0,0 +1,224 @@
+/*
+ * deferred-format binary tracing. trace() call sites store the id of their static format
+ * descriptor, the raw arguments and a cycle timestamp into a ring of the current hart.
+ * formatting happens only when the rings are drained: on panic, on shutdown (if
+ * TRACE_DRAIN_ON_SHUTDOWN), when exported as a Chrome trace (TRACE_CHROME_PATH), or on the
+ * host after trace_dump_file().
+ */
+
+#include <stdarg.h>
+
+#include "trace.h"
+#include "riscv.h"
+#include "config.h"
+#include "string.h"
+#include "util/functions.h"
+#include "util/snprintf.h"
+#include "process.h"
+
+#include "spike_interface/spike_utils.h"
+
+// the format descriptors, gathered by kernel/kernel.lds
+extern const trace_fmt __trace_fmt_start[], __trace_fmt_end[];
+
+typedef struct trace_ring_t {
+  // number of records ever reserved. the ring keeps the last TRACE_RING_SIZE of them.
+  uint64 head;
+  trace_rec recs[TRACE_RING_SIZE];
+} trace_ring;
+
+_Static_assert((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0, "bad TRACE_RING_SIZE");
+
+static trace_ring rings[NCPU] __attribute__((aligned(64)));
+
+// set while the rings are being read out, which must not record its own HTIF requests
+static volatile int paused = 0;
+
+//
+// the rings are written only by their own hart. a slot is reserved with an atomic add, so
+// a trap taken in the middle of trace_record() can record its own events safely.
+//
+void trace_record(const trace_fmt *f, ...) {
+  uint64 hart = read_tp();
+  // tp is not the hartid in M-mode traps from the user, which we do not trace
+  if (paused || hart >= NCPU) return;
+
+  trace_ring *ring = &rings[hart];
+  uint64 slot = __atomic_fetch_add(&ring->head, 1, __ATOMIC_RELAXED);
+  trace_rec *rec = &ring->recs[slot & (TRACE_RING_SIZE - 1)];
+
+  rec->tsc = read_cycle();
+  rec->id = f - __trace_fmt_start;
+  rec->nargs = f->nargs;
+  rec->pid = current ? current->pid : 0;
+
+  va_list vl;
+  va_start(vl, f);
+  for (int i = 0; i < f->nargs; i++) rec->args[i] = va_arg(vl, uint64);
+  va_end(vl);
+}
+
+// index of the oldest record still in ring
+static uint64 ring_first(const trace_ring *ring) {
+  return ring->head > TRACE_RING_SIZE ? ring->head - TRACE_RING_SIZE : 0;
+}
+
+static const char *phase_prefix(const trace_fmt *f) {
+  return f->phase == TRACE_BEGIN ? "begin " : f->phase == TRACE_END ? "end " : "";
+}
+
+void trace_drain(void) {
+  paused = 1;
+  for (int hart = 0; hart < NCPU; hart++) {
+    trace_ring *ring = &rings[hart];
+    if (!ring->head) continue;
+
+    sprint("---- trace of hart %d: %ld events (%ld dropped) ----\n", hart, ring->head,
+           ring_first(ring));
+    for (uint64 i = ring_first(ring); i < ring->head; i++) {
+      const trace_rec *rec = &ring->recs[i & (TRACE_RING_SIZE - 1)];
+      const trace_fmt *f = &__trace_fmt_start[rec->id];
+      const uint64 *a = rec->args;
+
+      sprint("%12ld [pid %d] %s:%d: %s", rec->tsc, rec->pid, f->file, f->line, phase_prefix(f));
+      // every argument was widened to 64 bits, which is also how RV64 passes varargs
+      sprint(f->fmt, a[0], a[1], a[2], a[3], a[4], a[5]);
+      sprint("\n");
+    }
+  }
+  paused = 0;
+}
+
+//
+// binary layout of the dump (little endian), read by tools/trace_decode.py:
+//   header:  "PKETRACE", uint32 version, uint32 nfmts, uint32 nharts, uint32 record size
+//   nfmts x: uint32 line, uint32 nargs, uint32 phase, uint32 fmt length, uint32 file length,
+//            fmt, file
+//   nharts x: uint32 hart, uint32 nrecs, nrecs trace_rec, oldest first
+//
+#define TRACE_DUMP_VERSION 2
+
+static int dump_write(spike_file_t *f, const void *buf, size_t n) {
+  return spike_file_write(f, buf, n) == n ? 0 : -1;
+}
+
+int trace_dump_file(const char *path) {
+  spike_file_t *f = spike_file_open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (IS_ERR_VALUE(f)) return -1;
+
+  paused = 1;
+  int err = 0;
+  uint32 header[4] = {TRACE_DUMP_VERSION, __trace_fmt_end - __trace_fmt_start, NCPU,
+                      sizeof(trace_rec)};
+  err |= dump_write(f, "PKETRACE", 8);
+  err |= dump_write(f, header, sizeof(header));
+
+  for (const trace_fmt *fmt = __trace_fmt_start; fmt < __trace_fmt_end; fmt++) {
+    uint32 desc[5] = {fmt->line, fmt->nargs, fmt->phase, strlen(fmt->fmt), strlen(fmt->file)};
+    err |= dump_write(f, desc, sizeof(desc));
+    err |= dump_write(f, fmt->fmt, desc[3]);
+    err |= dump_write(f, fmt->file, desc[4]);
+  }
+
+  for (uint32 hart = 0; hart < NCPU; hart++) {
+    trace_ring *ring = &rings[hart];
+    uint64 first = ring_first(ring);
+    uint32 count[2] = {hart, ring->head - first};
+    err |= dump_write(f, count, sizeof(count));
+
+    // the live part of the ring is at most two contiguous pieces
+    uint64 start = first & (TRACE_RING_SIZE - 1);
+    uint64 n1 = MIN(count[1], TRACE_RING_SIZE - start);
+    err |= dump_write(f, &ring->recs[start], n1 * sizeof(trace_rec));
+    err |= dump_write(f, &ring->recs[0], (count[1] - n1) * sizeof(trace_rec));
+  }
+
+  spike_file_close(f);
+  paused = 0;
+  return err;
+}
+
+// the JSON is gathered in out, and written to the host in large pieces
+typedef struct json_out_t {
+  spike_file_t *f;
+  char buf[4096];
+  uint64 len;
+  int err;
+} json_out;
+
+static void json_flush(json_out *o) {
+  o->err |= dump_write(o->f, o->buf, o->len);
+  o->len = 0;
+}
+
+// append s to o, escaped as the contents of a JSON string if quote is set
+static void json_put(json_out *o, const char *s, int quote) {
+  for (; *s; s++) {
+    if (o->len + 2 > sizeof(o->buf)) json_flush(o);
+    if (quote && (*s == '"' || *s == '\\')) o->buf[o->len++] = '\\';
+    o->buf[o->len++] = (quote && (uint8)*s < 0x20) ? ' ' : *s;
+  }
+}
+
+int trace_export_chrome(const char *path) {
+  static json_out o;
+  o.f = spike_file_open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (IS_ERR_VALUE(o.f)) return -1;
+  o.len = 0;
+  o.err = 0;
+
+  // timestamps are in microseconds. without a clock frequency in the DTB, we take spike's
+  // default of about one instruction, and cycle, per nanosecond.
+  uint64 mhz = g_platform.harts[0].clock_freq / 1000000;
+  if (!mhz) mhz = 1000;
+
+  paused = 1;
+  const char *sep = "";
+  json_put(&o, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [", 0);
+  for (int hart = 0; hart < NCPU; hart++) {
+    trace_ring *ring = &rings[hart];
+    for (uint64 i = ring_first(ring); i < ring->head; i++) {
+      const trace_rec *rec = &ring->recs[i & (TRACE_RING_SIZE - 1)];
+      const trace_fmt *f = &__trace_fmt_start[rec->id];
+      const uint64 *a = rec->args;
+      char name[128], event[160];
+
+      snprintf(name, sizeof(name), f->fmt, a[0], a[1], a[2], a[3], a[4], a[5]);
+      json_put(&o, sep, 0);
+      json_put(&o, "\n{\"name\": \"", 0);
+      json_put(&o, name, 1);
+      snprintf(event, sizeof(event),
+               "\", \"ph\": \"%c\", \"ts\": %ld.%03ld, \"pid\": %d, \"tid\": %d%s}",
+               f->phase, rec->tsc / mhz, rec->tsc % mhz * 1000 / mhz, rec->pid, hart,
+               f->phase == TRACE_INSTANT ? ", \"s\": \"t\"" : "");
+      json_put(&o, event, 0);
+      sep = ",";
+    }
+  }
+  json_put(&o, "\n]}\n", 0);
+  json_flush(&o);
+
+  spike_file_close(o.f);
+  paused = 0;
+  return o.err;
+}
+
+static void trace_shutdown(int code, int panic) {
+  if (panic || TRACE_DRAIN_ON_SHUTDOWN) trace_drain();
+  if (TRACE_CHROME_PATH[0] && trace_export_chrome(TRACE_CHROME_PATH) == 0)
+    sprint("Chrome trace written to %s\n", TRACE_CHROME_PATH);
+}
+
+// HTIF requests that wait for the host are file operations, whose syscall number is the
+// first word of the request
+static void trace_htif(uint64 dev, uint64 cmd, uint64 data, int done) {
+  if (!done)
+    trace_begin("htif %ld", dev == 0 && cmd == 0 ? *(uint64 *)data : cmd);
+  else
+    trace_end("htif");
+}
+
+void trace_init(void) {
+  register_shutdown_hook(trace_shutdown);
+  htif_set_hook(trace_htif);
+}
@@ -0,0 +1,65 @@
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include "util/types.h"
+
+#define TRACE_MAX_ARGS 6
+
+// kinds of events, the same letters as the "ph" of Chrome trace events
+#define TRACE_INSTANT 'i'
+#define TRACE_BEGIN 'B'  // the start of a span, closed by the next TRACE_END of the hart
+#define TRACE_END 'E'
+
+// static description of a trace point. each call site of trace() places one in the
+// "trace_fmt" section (see kernel/kernel.lds), and records carry its index in that section.
+typedef struct trace_fmt_t {
+  const char *fmt;  // printf format of the event, without the trailing newline
+  const char *file;
+  uint32 line;
+  uint16 nargs;
+  uint16 phase;  // TRACE_INSTANT, TRACE_BEGIN or TRACE_END
+} trace_fmt;
+
+// one event in a trace ring: 64 bytes, formatted only when the ring is drained
+typedef struct trace_rec_t {
+  uint64 tsc;   // cycle counter when the event was recorded
+  uint32 id;    // index of the trace_fmt of the event
+  uint16 nargs;
+  uint16 pid;   // process running at the time, 0 if none
+  uint64 args[TRACE_MAX_ARGS];
+} trace_rec;
+
+#define TRACE_NARGS(...) TRACE_NARGS_(0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+#define TRACE_NARGS_(_0, _1, _2, _3, _4, _5, _6, n, ...) n
+
+//
+// record an event in the trace ring of the current hart. fmt must be a string literal, and
+// there can be up to TRACE_MAX_ARGS integer or pointer arguments. the cost is a few stores;
+// formatting is deferred to trace_drain() or to the host (see tools/trace_decode.py).
+//
+#define trace_event(phase, fmt, ...)                                                     \
+  do {                                                                                   \
+    static const trace_fmt __trace_fmt __attribute__((section("trace_fmt"), used)) = {   \
+        fmt, __FILE__, __LINE__, TRACE_NARGS(__VA_ARGS__), phase};                       \
+    _Static_assert(TRACE_NARGS(__VA_ARGS__) <= TRACE_MAX_ARGS, "too many trace args"); \
+    trace_record(&__trace_fmt, ##__VA_ARGS__);                                           \
+  } while (0)
+
+#define trace(fmt, ...) trace_event(TRACE_INSTANT, fmt, ##__VA_ARGS__)
+// a span, shown as a bar on the timeline of trace_export_chrome()
+#define trace_begin(fmt, ...) trace_event(TRACE_BEGIN, fmt, ##__VA_ARGS__)
+#define trace_end(fmt, ...) trace_event(TRACE_END, fmt, ##__VA_ARGS__)
+
+void trace_record(const trace_fmt *f, ...);
+
+// print every recorded event on the console, oldest first
+void trace_drain(void);
+// write the rings in binary to a host file, returns 0 on success
+int trace_dump_file(const char *path);
+// write the rings as Chrome trace_event JSON to a host file, returns 0 on success
+int trace_export_chrome(const char *path);
+// hook up trace_drain() and trace_export_chrome() with shutdown and panic, and trace the
+// HTIF requests
+void trace_init(void);
+
+#endif
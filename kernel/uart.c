@@ -0,0 +1,172 @@
+/*
+ * an interrupt-driven driver of the NS16550 UART that newer spike versions (and QEMU virt)
+ * describe in the DTB. written bytes are queued in a transmit ring, which the transmitter
+ * drains a FIFO at a time, refilled from its "holding register empty" interrupt; received
+ * bytes are gathered in a receive ring by the "data available" interrupt. a write thus
+ * costs a copy, instead of an HTIF handshake per character.
+ *
+ * the rings are touched with interrupts off: by the interrupt handler, and by the readers
+ * and writers, which wait in wfi while the rings are empty (full).
+ */
+
+#include "uart.h"
+#include "riscv.h"
+#include "config.h"
+#include "plic.h"
+#include "idle.h"
+#include "util/functions.h"
+
+#include "spike_interface/spike_utils.h"
+
+// registers, (1 << uart_reg_shift) bytes apart
+#define UART_RBR 0  // receive buffer (read)
+#define UART_THR 0  // transmit holding (write)
+#define UART_DLL 0  // divisor latch, low byte, with LCR_DLAB
+#define UART_IER 1  // interrupt enable
+#define UART_DLM 1  // divisor latch, high byte, with LCR_DLAB
+#define UART_FCR 2  // FIFO control (write)
+#define UART_LCR 3  // line control
+#define UART_MCR 4  // modem control
+#define UART_LSR 5  // line status
+
+#define IER_RDI 0x01   // received data available
+#define IER_THRI 0x02  // transmit holding register empty
+#define FCR_FIFO 0x07  // enable and clear both FIFOs
+#define LCR_8N1 0x03
+#define LCR_DLAB 0x80  // divisor latch access
+#define MCR_OUT2 0x08  // lets the interrupt out, on PC-style UARTs
+#define LSR_DR 0x01    // data ready
+#define LSR_THRE 0x20  // transmit FIFO empty
+
+// bytes the transmit FIFO of a 16550 holds
+#define UART_FIFO 16
+
+_Static_assert((UART_TX_BUF & (UART_TX_BUF - 1)) == 0, "bad UART_TX_BUF");
+_Static_assert((UART_RX_BUF & (UART_RX_BUF - 1)) == 0, "bad UART_RX_BUF");
+
+static struct {
+  volatile uint8 *base;
+  uint32 shift;
+  uint8 ier;
+  // the rings hold [head, tail), the indices run freely
+  uint64 tx_head, tx_tail, rx_head, rx_tail;
+  char tx[UART_TX_BUF];
+  char rx[UART_RX_BUF];
+} uart;
+
+static struct {
+  uint64 tx, rx, intrs, dropped, tx_waits, rx_waits;
+} uart_stats;
+
+static inline uint8 reg_read(int reg) { return uart.base[reg << uart.shift]; }
+static inline void reg_write(int reg, uint8 v) { uart.base[reg << uart.shift] = v; }
+
+static void set_ier(uint8 ier) {
+  if (ier != uart.ier) reg_write(UART_IER, uart.ier = ier);
+}
+
+// move queued bytes to the transmitter while its FIFO is empty, and ask for an interrupt
+// when it drains if bytes are left
+static void uart_start_tx(void) {
+  while (uart.tx_head != uart.tx_tail && (reg_read(UART_LSR) & LSR_THRE))
+    for (int i = 0; i < UART_FIFO && uart.tx_head != uart.tx_tail; i++)
+      reg_write(UART_THR, uart.tx[uart.tx_head++ & (UART_TX_BUF - 1)]);
+  set_ier(uart.tx_head != uart.tx_tail ? IER_RDI | IER_THRI : IER_RDI);
+}
+
+static void uart_rx(void) {
+  while (reg_read(UART_LSR) & LSR_DR) {
+    char c = reg_read(UART_RBR);
+    if (uart.rx_tail - uart.rx_head == UART_RX_BUF) {
+      uart_stats.dropped++;
+      continue;
+    }
+    uart.rx[uart.rx_tail++ & (UART_RX_BUF - 1)] = c;
+    uart_stats.rx++;
+  }
+}
+
+// the interrupt of the UART: fill the receive ring, and refill the transmitter
+static void uart_intr(uint32 irq, void *arg) {
+  uart_stats.intrs++;
+  uart_rx();
+  uart_start_tx();
+}
+
+//
+// the transmitter is also polled in the loop, so that we get on even when called with
+// interrupts off, when the interrupt of the UART is not taken
+//
+int64 uart_write(const char *buf, uint64 n) {
+  uint64 done = 0;
+  while (done < n) {
+    int intr = intr_save();
+    uart_start_tx();
+    uint64 room = UART_TX_BUF - (uart.tx_tail - uart.tx_head);
+    if (room) {
+      for (uint64 end = done + MIN(room, n - done); done < end; done++)
+        uart.tx[uart.tx_tail++ & (UART_TX_BUF - 1)] = buf[done];
+      uart_start_tx();
+    } else {
+      uart_stats.tx_waits++;
+      idle_wait();
+    }
+    // a pending interrupt is taken here, if interrupts were on
+    intr_restore(intr);
+  }
+  uart_stats.tx += n;
+  return n;
+}
+
+int64 uart_read(char *buf, uint64 n) {
+  uint64 got = 0;
+  while (!got && n) {
+    int intr = intr_save();
+    uart_rx();
+    while (got < n && uart.rx_head != uart.rx_tail)
+      buf[got++] = uart.rx[uart.rx_head++ & (UART_RX_BUF - 1)];
+    if (!got) {
+      uart_stats.rx_waits++;
+      idle_wait();
+    }
+    intr_restore(intr);
+  }
+  return got;
+}
+
+static void uart_report(int code, int panic) {
+  sprint("uart: %ld bytes sent, %ld received (%ld dropped), %ld interrupts, %ld/%ld waits "
+         "to send/receive\n",
+         uart_stats.tx, uart_stats.rx, uart_stats.dropped, uart_stats.intrs,
+         uart_stats.tx_waits, uart_stats.rx_waits);
+}
+
+int uart_init(void) {
+  // without the PLIC, or an interrupt number, we would have to poll: leave it to HTIF
+  if (!g_platform.uart.base || !g_platform.plic.base || !g_platform.uart_irq) return 0;
+  uart.base = (volatile uint8 *)g_platform.uart.base;
+  uart.shift = g_platform.uart_reg_shift;
+
+  reg_write(UART_IER, uart.ier = 0);
+  uint32 divisor = g_platform.uart_clock_freq / (16 * UART_BAUD);
+  if (divisor) {
+    reg_write(UART_LCR, LCR_DLAB);
+    reg_write(UART_DLL, divisor & 0xff);
+    reg_write(UART_DLM, divisor >> 8);
+  }
+  reg_write(UART_LCR, LCR_8N1);
+  reg_write(UART_FCR, FCR_FIFO);
+  reg_write(UART_MCR, MCR_OUT2);
+
+  // plic_register() is defined in kernel/plic.c
+  if (plic_register(g_platform.uart_irq, "uart", UART_IRQ_PRIORITY, PLIC_IO_HARTS, uart_intr,
+                    0) != 0) {
+    sprint("uart: can not register irq %d\n", g_platform.uart_irq);
+    return 0;
+  }
+  set_ier(IER_RDI);
+  write_csr(sie, read_csr(sie) | SIE_SEIE);
+
+  register_shutdown_hook(uart_report);
+  return 1;
+}
@@ -0,0 +1,13 @@
+#ifndef _UART_H_
+#define _UART_H_
+
+#include "util/types.h"
+
+// set up the NS16550 UART of the DTB, with its interrupt. returns 0 if there is none.
+int uart_init(void);
+// queue n bytes for transmission, waiting while the transmit ring is full. returns n.
+int64 uart_write(const char *buf, uint64 n);
+// take up to n received bytes, waiting for at least one. returns the number taken.
+int64 uart_read(char *buf, uint64 n);
+
+#endif
@@ -0,0 +1,107 @@
+/*
+ * user stacks that grow on demand. a process starts with a small stack, and below it
+ * lies a guard region, which the user can not access: PMP entries, set by M-mode with
+ * MCALL_PMP_GUARD, deny it. an access there faults, and the stack grows down past the
+ * faulting address, the guard moving with it, until the stack reaches its limit.
+ *
+ * lab1 runs without paging, so the pages of the stack region are not allocated as the stack
+ * grows; but the guard turns a stack overflow into a clean error instead of silent
+ * corruption of the memory below, and the process is given only the stack it uses.
+ */
+
+#include "ustack.h"
+#include "riscv.h"
+#include "config.h"
+#include "pmm.h"
+#include "mcall.h"
+#include "process.h"
+#include "trace.h"
+#include "auxv.h"
+#include "util/functions.h"
+#include "util/string.h"
+
+#include "spike_interface/spike_utils.h"
+
+static struct {
+  uint64 grows, pages;
+} ustack_stats;
+
+static void ustack_report(int code, int panic);
+
+// copy the strings s[] to *str and onwards, and their addresses to vec[], then a NULL.
+// returns the word after the NULL.
+static uint64 *push_strings(uint64 *vec, char **str, char *const s[]) {
+  for (; *s; s++) {
+    size_t n = strlen(*s) + 1;
+    memcpy(*str, *s, n);
+    *vec++ = (uint64)*str;
+    *str += n;
+  }
+  *vec++ = 0;
+  return vec;
+}
+
+//
+// the initial stack, as the RISC-V psABI has it for Linux: sp (16-byte aligned) points at
+// argc, followed by argv[] and envp[], each ended by a NULL, and the auxiliary vector of
+// (type, value) pairs, ended by AT_NULL. the strings lie above, up to the top of the stack.
+//
+void ustack_init(process *p, char *const argv[], char *const envp[], const uint64 auxv[]) {
+  static int hooked = 0;
+  if (!hooked++) register_shutdown_hook(ustack_report);
+
+  int argc = 0, envc = 0, auxc = 0;
+  uint64 strings = 0;
+  for (; argv[argc]; argc++) strings += strlen(argv[argc]) + 1;
+  for (; envp[envc]; envc++) strings += strlen(envp[envc]) + 1;
+  while (auxv[2 * auxc] != AT_NULL) auxc++;
+  uint64 words = 1 + (argc + 1) + (envc + 1) + 2 * (auxc + 1);
+
+  p->stack_top = g_mem_layout.user_stack_top;
+  uint64 size = MIN(g_mem_layout.user_stack_top - g_mem_layout.user_stack_bottom,
+                    USER_STACK_RLIMIT);
+  // the guard must fit in the region when the stack is as large as it gets
+  p->stack_limit = p->stack_top - size + USER_STACK_GUARD;
+  uint64 sp = ROUNDDOWN(p->stack_top - strings - words * sizeof(uint64), 16);
+  p->stack_bottom = ROUNDDOWN(sp - USER_STACK_INITIAL, PGSIZE);
+  if (p->stack_bottom < p->stack_limit) panic("user stack limit is below the initial stack.\n");
+  memset((void *)p->stack_bottom, 0, p->stack_top - p->stack_bottom);
+
+  uint64 *vec = (uint64 *)sp;
+  char *str = (char *)(p->stack_top - strings);
+  *vec++ = argc;
+  vec = push_strings(vec, &str, argv);
+  vec = push_strings(vec, &str, envp);
+  memcpy(vec, auxv, 2 * (auxc + 1) * sizeof(uint64));
+
+  p->trapframe->regs.sp = sp;
+}
+
+int ustack_handle_fault(process *p, uint64 addr) {
+  if (addr >= p->stack_bottom || addr < p->stack_bottom - USER_STACK_GUARD) return 0;
+  if (addr < p->stack_limit) {
+    sprint("user stack overflow at 0x%lx: the stack is limited to %ld KB.\n", addr,
+           (p->stack_top - p->stack_limit) >> 10);
+    return 0;
+  }
+
+  uint64 bottom = ROUNDDOWN(addr, PGSIZE), old_bottom = p->stack_bottom;
+  trace("stack grows to %lx for %lx", bottom, addr);
+  ustack_stats.grows++;
+  ustack_stats.pages += (old_bottom - bottom) / PGSIZE;
+  p->stack_bottom = bottom;
+  // move the guard first: it denies the kernel too
+  ustack_switch(p);
+  memset((void *)bottom, 0, old_bottom - bottom);
+  return 1;
+}
+
+void ustack_switch(process *p) {
+  // served by handle_mcall() in kernel/machine/mtrap.c
+  mcall(MCALL_PMP_GUARD, p->stack_bottom - USER_STACK_GUARD, p->stack_bottom, 0);
+}
+
+static void ustack_report(int code, int panic) {
+  if (!ustack_stats.grows) return;
+  sprint("user stack: grown %ld times, by %ld pages\n", ustack_stats.grows, ustack_stats.pages);
+}
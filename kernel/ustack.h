@@ -0,0 +1,16 @@
+#ifndef _USTACK_H_
+#define _USTACK_H_
+
+#include "util/types.h"
+
+struct process_t;
+// give p a stack at the top of the user stack region, holding its arguments, environment
+// (both NULL-terminated) and auxiliary vector (ended by AT_NULL), and point its sp there
+void ustack_init(struct process_t *p, char *const argv[], char *const envp[],
+                 const uint64 auxv[]);
+// grow the stack of p, if addr (of a faulting access) is in its guard. returns 1 if it did.
+int ustack_handle_fault(struct process_t *p, uint64 addr);
+// move the guard to below the stack of p, which is about to run
+void ustack_switch(struct process_t *p);
+
+#endif
@@ -0,0 +1,160 @@
+/*
+ * lazy vector context switching, in the same way as kernel/fp.c does for FP: the vector
+ * registers belong to one process at a time, vec_owner, and sstatus.VS is Off for the
+ * others, whose first vector instruction traps. the registers of the owner are saved only
+ * if VS was Dirty, and the save areas (32 x VLEN bits) are allocated only for processes
+ * that use V.
+ *
+ * the kernel itself uses V in memcpy() and friends (util/string_rvv.S) as long as no
+ * process owns the vector unit, and the scalar versions afterwards.
+ */
+
+#include "vector.h"
+#include "riscv.h"
+#include "process.h"
+#include "pmm.h"
+#include "trace.h"
+#include "util/string.h"
+
+#include "spike_interface/spike_utils.h"
+
+int g_vec_available = 0;
+
+// the process whose vector state is in the registers, if any
+static process *vec_owner;
+// bytes in a vector register
+static uint64 vlenb;
+// sstatus.VS of the process that trapped, as vec_kernel_enter() found it
+static uint64 user_vs;
+
+static struct {
+  uint64 traps, saves, restores, bytes;
+} vec_stats;
+
+static void set_vs(uint64 vs) { write_csr(sstatus, (read_csr(sstatus) & ~SSTATUS_VS) | vs); }
+
+#define VEC_ASM(insns) ".option push\n.option arch, +v\n" insns "\n.option pop\n"
+
+static void vec_save(process *p) {
+  vec_context *v = &p->vec;
+  set_vs(SSTATUS_VS_CLEAN);
+  asm volatile(VEC_ASM("csrr %0, vstart\ncsrr %1, vl\ncsrr %2, vtype\ncsrr %3, vcsr")
+               : "=r"(v->vstart), "=r"(v->vl), "=r"(v->vtype), "=r"(v->vcsr));
+  // whole-register stores ignore vl and vtype, but start from vstart
+  asm volatile(VEC_ASM("csrw vstart, zero"));
+  asm volatile(VEC_ASM("vs8r.v v0, (%0)") : : "r"(v->regs[0]) : "memory");
+  asm volatile(VEC_ASM("vs8r.v v8, (%0)") : : "r"(v->regs[1]) : "memory");
+  asm volatile(VEC_ASM("vs8r.v v16, (%0)") : : "r"(v->regs[2]) : "memory");
+  asm volatile(VEC_ASM("vs8r.v v24, (%0)") : : "r"(v->regs[3]) : "memory");
+  p->vec_dirty = 0;
+  vec_stats.saves++;
+  vec_stats.bytes += 32 * vlenb;
+}
+
+static void vec_restore(process *p) {
+  vec_context *v = &p->vec;
+  set_vs(SSTATUS_VS_CLEAN);
+  asm volatile(VEC_ASM("csrw vstart, zero"));
+  asm volatile(VEC_ASM("vl8re8.v v0, (%0)") : : "r"(v->regs[0]) : "memory");
+  asm volatile(VEC_ASM("vl8re8.v v8, (%0)") : : "r"(v->regs[1]) : "memory");
+  asm volatile(VEC_ASM("vl8re8.v v16, (%0)") : : "r"(v->regs[2]) : "memory");
+  asm volatile(VEC_ASM("vl8re8.v v24, (%0)") : : "r"(v->regs[3]) : "memory");
+  // vsetvl restores vl (not above VLMAX of vtype) and vtype, including vill
+  asm volatile(VEC_ASM("vsetvl x0, %0, %1") : : "r"(v->vl), "r"(v->vtype));
+  asm volatile(VEC_ASM("csrw vstart, %0\ncsrw vcsr, %1") : : "r"(v->vstart), "r"(v->vcsr));
+  vec_stats.restores++;
+  vec_stats.bytes += 32 * vlenb;
+}
+
+//
+// the save area of a process: VEC_GROUPS pieces of 8 * vlenb bytes, carved out of as few
+// kernel pages as possible. the pages, zeroed, are also the initial state of the registers.
+//
+static void vec_alloc(process *p) {
+  uint64 group = 8 * vlenb;
+  if (group > PGSIZE) panic("VLEN of %ld bits is not supported.\n", vlenb * 8);
+
+  uint8 *page = NULL;
+  uint64 used = PGSIZE;
+  for (int i = 0; i < VEC_GROUPS; i++) {
+    if (used + group > PGSIZE) {
+      // alloc_page() is defined in kernel/pmm.c
+      page = alloc_page();
+      if (!page) panic("no free page for the vector registers of pid %d.\n", p->pid);
+      memset(page, 0, PGSIZE);
+      used = 0;
+    }
+    p->vec.regs[i] = page + used;
+    used += group;
+  }
+  // vill set: no vector configuration until the process sets one
+  p->vec.vtype = 1UL << 63;
+}
+
+// make the registers hold the vector state of p, saving those of the owner first if needed
+static void vec_take(process *p) {
+  if (vec_owner && vec_owner->vec_dirty) vec_save(vec_owner);
+  if (!vec_owner) {
+    // the registers are no longer scratch space for the kernel. string_disable_vector() is
+    // defined in util/string.c
+    string_disable_vector();
+  }
+  if (!p->vec.regs[0]) vec_alloc(p);
+  vec_restore(p);
+  vec_owner = p;
+  p->vec_used = 1;
+}
+
+//
+// on entering the kernel from a process: keep the vector unit on for the kernel's own use,
+// unless it is taken by a process. the VS of the process is kept for vec_handle_trap().
+//
+void vec_kernel_enter(void) {
+  if (!g_vec_available) return;
+  user_vs = read_csr(sstatus) & SSTATUS_VS;
+  if (!vec_owner) set_vs(SSTATUS_VS_CLEAN);
+}
+
+//
+// called by switch_to() whenever it returns to next, which replaces prev (NULL at first) or
+// is prev itself. the kernel may have left VS on for its own use, so this is needed even
+// without a change of process.
+//
+void vec_switch(process *prev, process *next) {
+  if (!g_vec_available) return;
+
+  if (prev && prev == vec_owner && (read_csr(sstatus) & SSTATUS_VS) == SSTATUS_VS_DIRTY)
+    prev->vec_dirty = 1;
+
+  if (next == vec_owner)
+    set_vs(next->vec_dirty ? SSTATUS_VS_DIRTY : SSTATUS_VS_CLEAN);
+  else
+    set_vs(SSTATUS_VS_OFF);
+}
+
+//
+// an illegal-instruction trap of p. if VS was Off for p, it is probably p using V for the
+// first time since it was switched in: give it the vector registers, and have it retry the
+// instruction. returns 0 if the instruction is illegal after all. the VS of p is the one
+// vec_kernel_enter() saw: by now the kernel may have turned V on for itself.
+//
+int vec_handle_trap(process *p) {
+  if (!g_vec_available || user_vs != SSTATUS_VS_OFF) return 0;
+
+  trace("vec: trap of pid %d, owner pid %d", p->pid, vec_owner ? vec_owner->pid : 0);
+  vec_stats.traps++;
+  vec_take(p);
+  return 1;
+}
+
+static void vec_report(int code, int panic) {
+  sprint("Vector context: %ld traps, %ld saves, %ld restores, %ld KB moved\n", vec_stats.traps,
+         vec_stats.saves, vec_stats.restores, vec_stats.bytes >> 10);
+}
+
+void vec_init(void) {
+  if (!g_vec_available) return;
+  set_vs(SSTATUS_VS_CLEAN);
+  asm volatile(VEC_ASM("csrr %0, vlenb") : "=r"(vlenb));
+  register_shutdown_hook(vec_report);
+}
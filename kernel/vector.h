@@ -0,0 +1,24 @@
+#ifndef _VECTOR_H_
+#define _VECTOR_H_
+
+#include "util/types.h"
+
+#define VEC_GROUPS 4  // the 32 vector registers are saved as 4 groups of 8
+
+// vector state of a process. the register save areas are VLEN dependent, and allocated on
+// the first use of V by the process.
+typedef struct vec_context_t {
+  uint64 vstart, vl, vtype, vcsr;
+  uint8 *regs[VEC_GROUPS];  // v0-v7, v8-v15, v16-v23, v24-v31, 8 * vlenb bytes each
+} vec_context;
+
+// set by m_start(), which can read misa, if the hart has the V extension
+extern int g_vec_available;
+
+struct process_t;
+void vec_init(void);
+void vec_kernel_enter(void);
+void vec_switch(struct process_t *prev, struct process_t *next);
+int vec_handle_trap(struct process_t *p);
+
+#endif
@@ -5,10 +5,19 @@
 #ifndef _RISCV_ATOMIC_H_
 #define _RISCV_ATOMIC_H_
 
-// Currently, interrupts are always disabled in M-mode.
-// todo: for PKE, wo turn on irq in lab_1_3_timer, so wo have to implement these two functions.
-#define disable_irqsave() (0)
-#define enable_irqrestore(flags) ((void)(flags))
+// interrupts are always disabled in M-mode, but the S-mode kernel lets them in during
+// syscalls (see kernel/strap.c). a lock taken with them on could be wanted again by an
+// interrupt handler on the same hart, which would spin forever: turn off sstatus.SIE (bit 1)
+// while the lock is held. M-mode may clear and restore it too, which changes nothing.
+static inline long disable_irqsave(void) {
+  long sstatus;
+  asm volatile("csrrci %0, sstatus, 2" : "=r"(sstatus) : : "memory");
+  return sstatus & 2;
+}
+
+static inline void enable_irqrestore(long flags) {
+  if (flags) asm volatile("csrsi sstatus, 2" : : : "memory");
+}
 
 typedef struct {
   int lock;
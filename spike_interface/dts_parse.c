@@ -14,8 +14,16 @@ static inline uint32 bswap(uint32 x) {
   return z;
 }
 
-static uint32 *fdt_scan_helper(uint32 *lex, const char *strings, struct fdt_scan_node *node,
-                               const struct fdt_cb *cb) {
+// the string block of the FDT being scanned, with the offsets of the cell-count properties
+// that fdt_scan_helper interprets itself.
+struct fdt_strings {
+  const char *base;
+  uint32 address_cells;
+  uint32 size_cells;
+};
+
+static uint32 *fdt_scan_helper(uint32 *lex, const struct fdt_strings *strings,
+                               struct fdt_scan_node *node, const struct fdt_cb *cb) {
   struct fdt_scan_node child;
   struct fdt_scan_prop prop;
   int last = 0;
@@ -34,13 +42,14 @@ static uint32 *fdt_scan_helper(uint32 *lex, const char *strings, struct fdt_scan
       }
       case FDT_PROP: {
         assert(!last);
-        prop.name = strings + bswap(lex[2]);
+        prop.nameoff = bswap(lex[2]);
+        prop.name = strings->base + prop.nameoff;
         prop.len = bswap(lex[1]);
         prop.value = lex + 3;
-        if (node && !strcmp(prop.name, "#address-cells")) {
+        if (node && prop.nameoff == strings->address_cells) {
           node->address_cells = bswap(lex[3]);
         }
-        if (node && !strcmp(prop.name, "#size-cells")) {
+        if (node && prop.nameoff == strings->size_cells) {
           node->size_cells = bswap(lex[3]);
         }
         lex += 3 + (prop.len + 3) / 4;
@@ -86,14 +95,50 @@ const uint32 *fdt_get_size(const struct fdt_scan_node *node, const uint32 *value
   return value;
 }
 
-void fdt_scan(uint64 fdt, const struct fdt_cb *cb) {
-  struct fdt_header *header = (struct fdt_header *)fdt;
+uint32 fdt_get_value(const struct fdt_scan_prop *prop, uint32 index) {
+  return bswap(prop->value[index]);
+}
 
+int fdt_string_list_index(const struct fdt_scan_prop *prop, const char *str) {
+  const char *list = (const char *)prop->value;
+  const char *end = list + prop->len;
+  int index = 0;
+  while (end - list > 0) {
+    if (!strcmp(list, str)) return index;
+    ++index;
+    list += strlen(list) + 1;
+  }
+  return -1;
+}
+
+static int fdt_valid(const struct fdt_header *header) {
   // Only process FDT that we understand
-  if (bswap(header->magic) != FDT_MAGIC || bswap(header->last_comp_version) > FDT_VERSION) return;
+  return bswap(header->magic) == FDT_MAGIC && bswap(header->last_comp_version) <= FDT_VERSION;
+}
+
+uint32 fdt_string_offset(uint64 fdt, const char *name) {
+  struct fdt_header *header = (struct fdt_header *)fdt;
+  if (!fdt_valid(header)) return FDT_NO_STRING;
 
   const char *strings = (const char *)(fdt + bswap(header->off_dt_strings));
+  uint32 size = bswap(header->size_dt_strings);
+  size_t len = strlen(name) + 1;
+
+  // dtc reuses the first match (possibly the tail of a longer name), so do we.
+  for (uint32 off = 0; off + len <= size; off++)
+    if (strings[off] == name[0] && !memcmp(strings + off, name, len)) return off;
+  return FDT_NO_STRING;
+}
+
+void fdt_scan(uint64 fdt, const struct fdt_cb *cb) {
+  struct fdt_header *header = (struct fdt_header *)fdt;
+  if (!fdt_valid(header)) return;
+
+  struct fdt_strings strings;
+  strings.base = (const char *)(fdt + bswap(header->off_dt_strings));
+  strings.address_cells = fdt_string_offset(fdt, "#address-cells");
+  strings.size_cells = fdt_string_offset(fdt, "#size-cells");
   uint32 *lex = (uint32 *)(fdt + bswap(header->off_dt_struct));
 
-  fdt_scan_helper(lex, strings, 0, cb);
+  fdt_scan_helper(lex, &strings, 0, cb);
 }
@@ -35,6 +35,7 @@ struct fdt_scan_node {
 struct fdt_scan_prop {
   const struct fdt_scan_node *node;
   const char *name;
+  uint32 nameoff;  // offset of name in the string block, see fdt_string_offset()
   uint32 *value;
   int len;  // in bytes of value
 };
@@ -49,13 +50,21 @@ struct fdt_cb {
   void *extra;
 };
 
+#define FDT_NO_STRING ((uint32)-1)
+
 // Scan the contents of FDT
 void fdt_scan(uint64 fdt, const struct fdt_cb *cb);
 uint32 fdt_size(uint64 fdt);
 
+// offset of a property name in the string block of FDT, FDT_NO_STRING if absent.
+// dtc stores every distinct name once, so properties can be matched by this offset
+// instead of comparing their names.
+uint32 fdt_string_offset(uint64 fdt, const char *name);
+
 // Extract fields
 const uint32 *fdt_get_address(const struct fdt_scan_node *node, const uint32 *base, uint64 *value);
 const uint32 *fdt_get_size(const struct fdt_scan_node *node, const uint32 *base, uint64 *value);
 int fdt_string_list_index(const struct fdt_scan_prop *prop,
                           const char *str);  // -1 if not found
+uint32 fdt_get_value(const struct fdt_scan_prop *prop, uint32 index);
 #endif
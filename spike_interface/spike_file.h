@@ -16,6 +16,10 @@ extern spike_file_t spike_files[];
 #define O_RDONLY 00
 #define O_WRONLY 01
 #define O_RDWR 02
+// the host (fesvr) receives the flags as they are, so these follow the Linux values
+#define O_CREAT 0100
+#define O_TRUNC 01000
+#define O_APPEND 02000
 #define ENOMEM 12 /* Out of memory */
 
 #define stdin (spike_files + 0)
@@ -1,6 +1,7 @@
 /*
- * HTIF (Host-Target InterFace) scanning. 
- * output: the availability of HTIF (indicated by "uint64 htif")
+ * HTIF (Host-Target InterFace) operations.
+ * the availability of HTIF (indicated by "uint64 htif") is discovered by query_platform()
+ * in spike_interface/spike_platform.c.
  *
  * HTIF is a powerful utility provided by the underlying emulator, i.e., Spike.
  * with HTIF, target environment (i.e., the RISC-V machine we use) can leverage 
@@ -14,49 +15,10 @@
 #include "spike_htif.h"
 #include "atomic.h"
 #include "spike_interface/spike_utils.h"
-#include "dts_parse.h"
 #include "string.h"
 
 uint64 htif;  //is Spike HTIF avaiable? initially 0 (false)
 
-///////////////////////////    Spike HTIF discovering    //////////////////////////////
-struct htif_scan {
-  int compat;
-};
-
-static void htif_open(const struct fdt_scan_node *node, void *extra) {
-  struct htif_scan *scan = (struct htif_scan *)extra;
-  memset(scan, 0, sizeof(*scan));
-}
-
-static void htif_prop(const struct fdt_scan_prop *prop, void *extra) {
-  struct htif_scan *scan = (struct htif_scan *)extra;
-  if (!strcmp(prop->name, "compatible") && !strcmp((const char *)prop->value, "ucb,htif0")) {
-    scan->compat = 1;
-  }
-}
-
-static void htif_done(const struct fdt_scan_node *node, void *extra) {
-  struct htif_scan *scan = (struct htif_scan *)extra;
-  if (!scan->compat) return;
-
-  htif = 1;
-}
-
-// scanning the HTIF
-void query_htif(uint64 fdt) {
-  struct fdt_cb cb;
-  struct htif_scan scan;
-
-  memset(&cb, 0, sizeof(cb));
-  cb.open = htif_open;
-  cb.prop = htif_prop;
-  cb.done = htif_done;
-  cb.extra = &scan;
-
-  fdt_scan(fdt, &cb);
-}
-
 /////////////////////////    Spike HTIF basic operations    //////////////////////////
 volatile uint64_t tohost __attribute__((section(".htif")));
 volatile uint64_t fromhost __attribute__((section(".htif")));
@@ -71,6 +33,9 @@ extern uint64_t __htif_base;
 
 volatile int htif_console_buf;
 static spinlock_t htif_lock = SPINLOCK_INIT;
+static htif_hook_t htif_hook;
+
+void htif_set_hook(htif_hook_t hook) { htif_hook = hook; }
 
 static void __check_fromhost(void) {
   uint64_t fh = fromhost;
@@ -96,9 +61,12 @@ static void __set_tohost(uint64 dev, uint64 cmd, uint64 data) {
 }
 
 static void do_tohost_fromhost(uint64 dev, uint64 cmd, uint64 data) {
-  spinlock_lock(&htif_lock);
+  if (htif_hook) htif_hook(dev, cmd, data, 0);
+  long flags = spinlock_lock_irqsave(&htif_lock);
   __set_tohost(dev, cmd, data);
 
+  // the host answers in fromhost without raising an interrupt, so we poll for it: wfi
+  // would sleep until the next timer interrupt, which a tickless kernel may never arm.
   while (1) {
     uint64_t fh = fromhost;
     if (fh) {
@@ -109,7 +77,8 @@ static void do_tohost_fromhost(uint64 dev, uint64 cmd, uint64 data) {
       __check_fromhost();
     }
   }
-  spinlock_unlock(&htif_lock);
+  spinlock_unlock_irqrestore(&htif_lock, flags);
+  if (htif_hook) htif_hook(dev, cmd, data, 1);
 }
 
 /////////////////////    Encapsulated Spike HTIF functionalities    //////////////////
@@ -126,9 +95,9 @@ void htif_console_putchar(uint8_t ch) {
   magic_mem[3] = 1;
   do_tohost_fromhost(0, 0, (uint64)magic_mem);
 #else
-  spinlock_lock(&htif_lock);
+  long flags = spinlock_lock_irqsave(&htif_lock);
   __set_tohost(1, 1, ch);
-  spinlock_unlock(&htif_lock);
+  spinlock_unlock_irqrestore(&htif_lock, flags);
 #endif
 }
 
@@ -138,21 +107,23 @@ int htif_console_getchar(void) {
   return -1;
 #endif
 
-  spinlock_lock(&htif_lock);
+  long flags = spinlock_lock_irqsave(&htif_lock);
   __check_fromhost();
   int ch = htif_console_buf;
   if (ch >= 0) {
     htif_console_buf = -1;
     __set_tohost(1, 0, 0);
   }
-  spinlock_unlock(&htif_lock);
+  spinlock_unlock_irqrestore(&htif_lock, flags);
 
   return ch - 1;
 }
 
 void htif_poweroff(void) {
+  // the host stops us once it sees the request. wait for that in wfi, not spinning.
   while (1) {
     fromhost = 0;
     tohost = 1;
+    asm volatile("wfi");
   }
 }
@@ -92,7 +92,6 @@
 #define AT_FDCWD -100
 
 extern uint64 htif;
-void query_htif(uint64 dtb);
 
 // Spike HTIF functionalities
 void htif_syscall(uint64);
@@ -101,4 +100,9 @@ void htif_console_putchar(uint8_t);
 int htif_console_getchar();
 void htif_poweroff() __attribute__((noreturn));
 
+// hook called when a request that waits for the host is sent (done = 0) and when the host
+// has completed it (done = 1), e.g., to trace the time spent in the host
+typedef void (*htif_hook_t)(uint64 dev, uint64 cmd, uint64 data, int done);
+void htif_set_hook(htif_hook_t hook);
+
 #endif
@@ -0,0 +1,202 @@
+/*
+ * discovering the platform resources (memory, harts, HTIF, CLINT, PLIC and UART) of the
+ * emulated machine from the DTS (Device Tree String), in a single pass over the FDT.
+ * output: g_platform, and the "uint64 htif" / "uint64 g_mem_size" shortcuts.
+ *
+ * property names are matched by their offsets in the FDT string block, which are looked up
+ * once before the scan, so visiting a property costs an integer compare per known name.
+ */
+
+#include "dts_parse.h"
+#include "spike_platform.h"
+#include "spike_interface/spike_utils.h"
+#include "string.h"
+#include "util/functions.h"
+
+platform_info g_platform;
+uint64 g_mem_size;
+
+// kinds of nodes we are interested in
+enum {
+  NODE_OTHER = 0,
+  NODE_MEMORY,
+  NODE_CPU,
+  NODE_HTIF,
+  NODE_CLINT,
+  NODE_PLIC,
+  NODE_UART,
+};
+
+// the property names we look for, in the order of the fields of struct platform_names
+static const char *const prop_names[] = {
+    "compatible",      "device_type", "reg",        "status",    "riscv,isa", "timebase-frequency",
+    "clock-frequency", "interrupts",  "riscv,ndev", "reg-shift",
+};
+
+struct platform_names {
+  uint32 compatible, device_type, reg, status, isa, timebase_freq, clock_freq, interrupts, ndev,
+      reg_shift;
+};
+
+struct platform_scan {
+  // offsets of prop_names[] in the string block of the FDT being scanned
+  union {
+    struct platform_names name;
+    uint32 offsets[ARRAY_SIZE(prop_names)];
+  };
+
+  // properties of the node being scanned, reset when a node is opened
+  struct {
+    int kind;
+    int disabled;
+    const uint32 *reg_value;
+    int reg_len;
+    const char *isa;
+    uint64 clock_freq;
+    uint32 irq;
+    uint32 ndev;
+    uint32 reg_shift;
+  } node;
+};
+
+static int node_kind(const struct fdt_scan_prop *prop, const struct platform_scan *scan) {
+  if (prop->nameoff == scan->name.device_type) {
+    if (!strcmp((const char *)prop->value, "memory")) return NODE_MEMORY;
+    if (!strcmp((const char *)prop->value, "cpu")) return NODE_CPU;
+  } else if (prop->nameoff == scan->name.compatible) {
+    if (fdt_string_list_index(prop, "ucb,htif0") >= 0) return NODE_HTIF;
+    if (fdt_string_list_index(prop, "riscv,clint0") >= 0 ||
+        fdt_string_list_index(prop, "sifive,clint0") >= 0)
+      return NODE_CLINT;
+    if (fdt_string_list_index(prop, "riscv,plic0") >= 0 ||
+        fdt_string_list_index(prop, "sifive,plic-1.0.0") >= 0)
+      return NODE_PLIC;
+    if (fdt_string_list_index(prop, "ns16550a") >= 0 ||
+        fdt_string_list_index(prop, "ns16550") >= 0)
+      return NODE_UART;
+  }
+  return NODE_OTHER;
+}
+
+static uint64 prop_u64(const struct fdt_scan_prop *prop) {
+  uint64 value = fdt_get_value(prop, 0);
+  if (prop->len >= 8) value = (value << 32) | fdt_get_value(prop, 1);
+  return value;
+}
+
+static void platform_open(const struct fdt_scan_node *node, void *extra) {
+  struct platform_scan *scan = (struct platform_scan *)extra;
+  memset(&scan->node, 0, sizeof(scan->node));
+}
+
+static void platform_prop(const struct fdt_scan_prop *prop, void *extra) {
+  struct platform_scan *scan = (struct platform_scan *)extra;
+  uint32 name = prop->nameoff;
+
+  if (name == scan->name.compatible || name == scan->name.device_type) {
+    int kind = node_kind(prop, scan);
+    if (kind != NODE_OTHER) scan->node.kind = kind;
+  } else if (name == scan->name.reg) {
+    scan->node.reg_value = prop->value;
+    scan->node.reg_len = prop->len;
+  } else if (name == scan->name.status) {
+    scan->node.disabled = strcmp((const char *)prop->value, "okay") != 0 &&
+                     strcmp((const char *)prop->value, "ok") != 0;
+  } else if (name == scan->name.isa) {
+    scan->node.isa = (const char *)prop->value;
+  } else if (name == scan->name.timebase_freq) {
+    // found on the "cpus" node, or on each "cpu" node
+    g_platform.timebase_freq = prop_u64(prop);
+  } else if (name == scan->name.clock_freq) {
+    scan->node.clock_freq = prop_u64(prop);
+  } else if (name == scan->name.interrupts) {
+    scan->node.irq = fdt_get_value(prop, 0);
+  } else if (name == scan->name.ndev) {
+    scan->node.ndev = fdt_get_value(prop, 0);
+  } else if (name == scan->name.reg_shift) {
+    scan->node.reg_shift = fdt_get_value(prop, 0);
+  }
+}
+
+// the first (address, size) pair in "reg" of node
+static int first_reg(const struct fdt_scan_node *node, const struct platform_scan *scan,
+                     platform_dev *dev) {
+  if (!scan->node.reg_value) return 0;
+  const uint32 *value = fdt_get_address(node->parent, scan->node.reg_value, &dev->base);
+  fdt_get_size(node->parent, value, &dev->size);
+  return 1;
+}
+
+static void platform_done(const struct fdt_scan_node *node, void *extra) {
+  struct platform_scan *scan = (struct platform_scan *)extra;
+  if (scan->node.kind == NODE_OTHER || scan->node.disabled) return;
+
+  switch (scan->node.kind) {
+    case NODE_MEMORY: {
+      const uint32 *value = scan->node.reg_value;
+      const uint32 *end = value + scan->node.reg_len / 4;
+      uint64 self = (uint64)platform_done;
+
+      assert(scan->node.reg_value && scan->node.reg_len % 4 == 0);
+      while (end - value > 0) {
+        uint64 base, size;
+        value = fdt_get_address(node->parent, value, &base);
+        value = fdt_get_size(node->parent, value, &size);
+        if (g_platform.nmem < PLATFORM_MAX_MEM_BANKS) {
+          g_platform.mem[g_platform.nmem].base = base;
+          g_platform.mem[g_platform.nmem].size = size;
+          g_platform.nmem++;
+        }
+        if (base <= self && self <= base + size) g_mem_size = size;
+      }
+      assert(end == value);
+      break;
+    }
+    case NODE_CPU: {
+      if (!scan->node.reg_value || g_platform.nharts >= PLATFORM_MAX_HARTS) break;
+      platform_hart *hart = &g_platform.harts[g_platform.nharts++];
+      fdt_get_address(node->parent, scan->node.reg_value, &hart->hartid);
+      hart->clock_freq = scan->node.clock_freq;
+      hart->isa = scan->node.isa;
+      break;
+    }
+    case NODE_HTIF:
+      g_platform.htif = 1;
+      htif = 1;
+      break;
+    case NODE_CLINT:
+      first_reg(node, scan, &g_platform.clint);
+      break;
+    case NODE_PLIC:
+      if (first_reg(node, scan, &g_platform.plic)) g_platform.plic_ndev = scan->node.ndev;
+      break;
+    case NODE_UART:
+      if (first_reg(node, scan, &g_platform.uart)) {
+        g_platform.uart_clock_freq = scan->node.clock_freq;
+        g_platform.uart_irq = scan->node.irq;
+        g_platform.uart_reg_shift = scan->node.reg_shift;
+      }
+      break;
+  }
+}
+
+// scanning the platform resources
+void query_platform(uint64 fdt) {
+  struct fdt_cb cb;
+  struct platform_scan scan;
+
+  memset(&scan, 0, sizeof(scan));
+  for (int i = 0; i < ARRAY_SIZE(prop_names); i++)
+    scan.offsets[i] = fdt_string_offset(fdt, prop_names[i]);
+
+  memset(&cb, 0, sizeof(cb));
+  cb.open = platform_open;
+  cb.prop = platform_prop;
+  cb.done = platform_done;
+  cb.extra = &scan;
+
+  memset(&g_platform, 0, sizeof(g_platform));
+  g_mem_size = 0;
+  fdt_scan(fdt, &cb);
+  assert(g_mem_size > 0);
+}
@@ -0,0 +1,61 @@
+#ifndef _SPIKE_PLATFORM_H_
+#define _SPIKE_PLATFORM_H_
+
+#include "util/types.h"
+
+#define PLATFORM_MAX_MEM_BANKS 4
+#define PLATFORM_MAX_HARTS 8
+
+typedef struct platform_mem_bank_t {
+  uint64 base;
+  uint64 size;
+} platform_mem_bank;
+
+typedef struct platform_hart_t {
+  uint64 hartid;
+  // clock frequency of the core in Hz, 0 if the DTB does not give one
+  uint64 clock_freq;
+  // "riscv,isa" string of the core, points into the DTB
+  const char *isa;
+} platform_hart;
+
+// MMIO window of a device, base is 0 if the device is absent
+typedef struct platform_dev_t {
+  uint64 base;
+  uint64 size;
+} platform_dev;
+
+// everything PKE needs to know about the emulated machine, filled in by one pass over the DTB.
+typedef struct platform_info_t {
+  int htif;
+
+  int nmem;
+  platform_mem_bank mem[PLATFORM_MAX_MEM_BANKS];
+
+  int nharts;
+  platform_hart harts[PLATFORM_MAX_HARTS];
+  // frequency of the mtime counter in Hz
+  uint64 timebase_freq;
+
+  platform_dev clint;
+
+  platform_dev plic;
+  // number of interrupt sources of the PLIC (riscv,ndev)
+  uint32 plic_ndev;
+
+  platform_dev uart;
+  uint64 uart_clock_freq;
+  // PLIC source number of the UART
+  uint32 uart_irq;
+  // registers are spaced (1 << uart_reg_shift) bytes apart
+  uint32 uart_reg_shift;
+} platform_info;
+
+// the cached result of query_platform(), to be consulted by later subsystems
+extern platform_info g_platform;
+// size of the memory bank holding the PKE kernel
+extern uint64 g_mem_size;
+
+void query_platform(uint64 fdt);
+
+#endif
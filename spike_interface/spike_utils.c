@@ -17,7 +17,7 @@ long frontend_syscall(long n, uint64 a0, uint64 a1, uint64 a2, uint64 a3, uint64
   static volatile uint64 magic_mem[8];
 
   static spinlock_t lock = SPINLOCK_INIT;
-  spinlock_lock(&lock);
+  long flags = spinlock_lock_irqsave(&lock);
 
   magic_mem[0] = n;
   magic_mem[1] = a0;
@@ -32,7 +32,7 @@ long frontend_syscall(long n, uint64 a0, uint64 a1, uint64 a2, uint64 a3, uint64
 
   long ret = magic_mem[0];
 
-  spinlock_unlock(&lock);
+  spinlock_unlock_irqrestore(&lock, flags);
   return ret;
 }
 
@@ -80,6 +80,30 @@ void sprint(const char* s, ...) {
 }
 
 //===============    Spike-assisted termination, panic and assert    ===============
+#define MAX_SHUTDOWN_HOOKS 8
+static void (*shutdown_hooks[MAX_SHUTDOWN_HOOKS])(int code, int panic);
+
+//
+// let the kernel run hook (e.g., to flush its logs) before the machine shuts down.
+// hooks run in the order they are registered. returns -1 if there is no room left.
+//
+int register_shutdown_hook(void (*hook)(int code, int panic)) {
+  for (int i = 0; i < MAX_SHUTDOWN_HOOKS; i++)
+    if (!shutdown_hooks[i]) {
+      shutdown_hooks[i] = hook;
+      return 0;
+    }
+  return -1;
+}
+
+static void run_shutdown_hooks(int code, int panic) {
+  // a hook that panics must not bring us here again
+  static int running = 0;
+  if (running) return;
+  running = 1;
+  for (int i = 0; i < MAX_SHUTDOWN_HOOKS && shutdown_hooks[i]; i++) shutdown_hooks[i](code, panic);
+}
+
 void poweroff(uint16_t code) {
   assert(htif);
   sprint("Power off\r\n");
@@ -95,17 +119,19 @@ void poweroff(uint16_t code) {
 }
 
 void shutdown(int code) {
+  run_shutdown_hooks(code, 0);
   sprint("System is shutting down with exit code %d.\n", code);
   frontend_syscall(HTIFSYS_exit, code, 0, 0, 0, 0, 0, 0);
-  while (1)
-    ;
+  // the host stops us after the exit request
+  while (1) asm volatile("wfi");
 }
 
 void do_panic(const char* s, ...) {
   va_list vl;
   va_start(vl, s);
 
-  sprint(s, vl);
+  vprintk(s, vl);
+  run_shutdown_hooks(-1, 1);
   shutdown(-1);
 
   va_end(vl);
@@ -3,7 +3,7 @@
 
 #include "util/types.h"
 #include "spike_file.h"
-#include "spike_memory.h"
+#include "spike_platform.h"
 #include "spike_htif.h"
 
 long frontend_syscall(long n, uint64 a0, uint64 a1, uint64 a2, uint64 a3, uint64 a4, uint64 a5,
@@ -13,6 +13,7 @@ void poweroff(uint16 code) __attribute((noreturn));
 void sprint(const char* s, ...);
 void putstring(const char* s);
 void shutdown(int) __attribute__((noreturn));
+int register_shutdown_hook(void (*hook)(int code, int panic));
 
 #define assert(x)                              \
   ({                                           \
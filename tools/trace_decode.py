@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+#
+# decode a kernel trace dump written by trace_dump_file() (kernel/trace.c), e.g., through
+# the trace_dump() call of the user library:
+#   $ python3 tools/trace_decode.py pke_trace.bin
+# events of all harts are merged and printed in timestamp order. with --chrome, they are
+# written as Chrome trace_event JSON instead (like trace_export_chrome() in the kernel):
+#   $ python3 tools/trace_decode.py --chrome pke_trace.json pke_trace.bin
+#
+
+import json
+import re
+import struct
+import sys
+
+SPEC = re.compile(r"%([-+ 0#]*)(\d+|\*)?(?:\.(\d+|\*))?(hh|h|ll|l|z|j|t)?([diuxXopsc%])")
+LONG = ("l", "ll", "z", "j", "t")
+
+
+def to_signed(value, bits):
+    value &= (1 << bits) - 1
+    return value - (1 << bits) if value >> (bits - 1) else value
+
+
+def format_event(fmt, args):
+    """printf-style formatting of fmt, with every argument given as a raw 64-bit value."""
+    args = list(args)
+
+    def take():
+        return args.pop(0) if args else 0
+
+    def convert(m):
+        flags, width, prec, length, conv = m.groups()
+        if conv == "%":
+            return "%"
+        if width == "*":
+            width = str(to_signed(take(), 32))
+        if prec == "*":
+            prec = str(to_signed(take(), 32))
+        bits = 64 if length in LONG else {"h": 16, "hh": 8}.get(length, 32)
+        value = take()
+        spec = "%" + flags + (width or "") + ("." + prec if prec is not None else "")
+        if conv in "di":
+            return (spec + "d") % to_signed(value, bits)
+        if conv == "u":
+            return (spec + "d") % (value & ((1 << bits) - 1))
+        if conv in "xXo":
+            return (spec + conv) % (value & ((1 << bits) - 1))
+        if conv == "p":
+            return "0x%016x" % value
+        if conv == "c":
+            return (spec + "c") % chr(value & 0xFF)
+        # strings live in the memory of the emulated machine, only their address is known
+        return (spec + "s") % ("<str@0x%x>" % value)
+
+    return SPEC.sub(convert, fmt)
+
+
+PHASE_PREFIX = {"B": "begin ", "E": "end "}
+
+
+def decode(data):
+    """yields (tsc, hart, pid, phase, fmt, file, line, args) of every event, in time order."""
+    if data[:8] != b"PKETRACE":
+        raise ValueError("not a PKE trace dump")
+    version, nfmts, nharts, rec_size = struct.unpack_from("<4I", data, 8)
+    if version != 2:
+        raise ValueError("unsupported trace dump version %d" % version)
+    off = 24
+
+    fmts = []
+    for _ in range(nfmts):
+        line, nargs, phase, fmt_len, file_len = struct.unpack_from("<5I", data, off)
+        off += 20
+        fmt = data[off:off + fmt_len].decode(errors="replace")
+        off += fmt_len
+        file = data[off:off + file_len].decode(errors="replace")
+        off += file_len
+        fmts.append((chr(phase), fmt, file, line))
+
+    events = []
+    nargs_max = (rec_size - 16) // 8
+    for _ in range(nharts):
+        hart, nrecs = struct.unpack_from("<2I", data, off)
+        off += 8
+        for _ in range(nrecs):
+            tsc, fid, nargs, pid = struct.unpack_from("<QIHH", data, off)
+            args = struct.unpack_from("<%dQ" % nargs_max, data, off + 16)[:nargs]
+            off += rec_size
+            events.append((tsc, hart, pid, fid, args))
+
+    events.sort()
+    for tsc, hart, pid, fid, args in events:
+        phase, fmt, file, line = fmts[fid]
+        yield tsc, hart, pid, phase, fmt, file, line, args
+
+
+def to_chrome(events, cycles_per_us=1000):
+    trace = []
+    for tsc, hart, pid, phase, fmt, file, line, args in events:
+        event = {"name": format_event(fmt, args), "ph": phase, "ts": tsc / cycles_per_us,
+                 "pid": pid, "tid": hart}
+        if phase == "i":
+            event["s"] = "t"
+        trace.append(event)
+    return {"displayTimeUnit": "ns", "traceEvents": trace}
+
+
+def main():
+    args = sys.argv[1:]
+    chrome = None
+    if len(args) == 3 and args[0] == "--chrome":
+        chrome, args = args[1], args[2:]
+    if len(args) != 1:
+        sys.exit("usage: %s [--chrome <json output>] <trace dump>" % sys.argv[0])
+    with open(args[0], "rb") as f:
+        events = decode(f.read())
+        if chrome:
+            with open(chrome, "w") as out:
+                json.dump(to_chrome(events), out)
+            return
+        for tsc, hart, pid, phase, fmt, file, line, args in events:
+            print("%12d [%d] [pid %d] %s:%d: %s%s" % (tsc, hart, pid, file, line,
+                                                    PHASE_PREFIX.get(phase, ""),
+                                                    format_event(fmt, args)))
+
+
+if __name__ == "__main__":
+    main()
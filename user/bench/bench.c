@@ -0,0 +1,32 @@
+/*
+ * the results are printed as lines of "BENCH {json}", which "make bench" collects into
+ * obj/bench_results.jsonl.
+ */
+
+#include "bench.h"
+#include "user/user_lib.h"
+#include "util/string.h"
+
+void bench_report(const char *name, unsigned long param, unsigned long iters,
+                  unsigned long cycles, unsigned long instret) {
+  printu("BENCH {\"name\": \"%s\", \"param\": %ld, \"iters\": %ld, \"cycles\": %ld, "
+         "\"instret\": %ld, \"cycles_per_iter\": %ld}\n",
+         name, param, iters, cycles, instret, iters ? cycles / iters : 0);
+}
+
+void bench_run(const char *name, unsigned long param, bench_fn fn, void *arg,
+               unsigned long iters) {
+  fn(arg, 1);
+
+  // read_cycle() and read_instret() read the counters directly, see user/user_lib.h
+  unsigned long c0 = read_cycle(), i0 = read_instret();
+  fn(arg, iters);
+  unsigned long c1 = read_cycle(), i1 = read_instret();
+
+  bench_report(name, param, iters, c1 - c0, i1 - i0);
+}
+
+unsigned long bench_param(int argc, char *argv[], int i, const char *env, unsigned long def) {
+  const char *s = i < argc ? argv[i] : getenv(env);
+  return s && *s ? atol(s) : def;
+}
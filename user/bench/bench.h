@@ -0,0 +1,26 @@
+/*
+ * common harness of the benchmark apps (user/bench/bench_*.c), built and run by
+ * "make bench".
+ */
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+// the code under measurement: do the work iters times
+typedef void (*bench_fn)(void *arg, unsigned long iters);
+
+//
+// run fn once to warm up, then measure iters rounds of it, and report the cycles and
+// retired instructions spent. param is the size or variant being measured, if any.
+//
+void bench_run(const char *name, unsigned long param, bench_fn fn, void *arg,
+               unsigned long iters);
+
+// report a measurement taken by the app itself
+void bench_report(const char *name, unsigned long param, unsigned long iters,
+                  unsigned long cycles, unsigned long instret);
+
+// a size or count to run with: argv[i] if given, else the environment variable env if set,
+// else def. e.g. "spike obj/riscv-pke BENCH_MAX_SIZE=4096 obj/bench_mem".
+unsigned long bench_param(int argc, char *argv[], int i, const char *env, unsigned long def);
+
+#endif
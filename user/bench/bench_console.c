@@ -0,0 +1,29 @@
+/*
+ * console output through write() on stdout, by the size of the writes: what a syscall and
+ * the copy to the transmit ring of the UART (or the HTIF fallback) cost per byte.
+ */
+
+#include "user/user_lib.h"
+#include "util/string.h"
+#include "bench.h"
+
+#define MAX_SIZE 4096
+#define TOTAL 16384
+
+static char line[MAX_SIZE];
+
+static void console_write(void *arg, unsigned long iters) {
+  unsigned long size = (unsigned long)arg;
+  for (unsigned long i = 0; i < iters; i++) write(STDOUT_FILENO, line, size);
+}
+
+int main(int argc, char *argv[]) {
+  // lines of dots, which do not get in the way of the BENCH lines
+  memset(line, '.', sizeof(line));
+  for (int i = 63; i < MAX_SIZE; i += 64) line[i] = '\n';
+
+  unsigned long total = bench_param(argc, argv, 1, "BENCH_CONSOLE_BYTES", TOTAL);
+  for (unsigned long size = 64; size <= MAX_SIZE; size *= 4)
+    bench_run("console_write", size, console_write, (void *)size, total / size);
+  exit(0);
+}
@@ -0,0 +1,35 @@
+/*
+ * stack growth faults (kernel/ustack.c): touching the page below the stack faults in its
+ * guard, and the kernel grows the stack over it. the pages are touched once more after
+ * they have grown, for the cost of the accesses alone.
+ */
+
+#include "user/user_lib.h"
+#include "bench.h"
+
+#define PAGE 4096
+// well within USER_STACK_RLIMIT (kernel/config.h)
+#define PAGES 512
+
+static void touch(unsigned long top) {
+  for (unsigned long i = 1; i <= PAGES; i++) *(volatile char *)(top - i * PAGE) = 1;
+}
+
+int main(void) {
+  // the pages below this frame, which the stack has not grown into yet
+  char here;
+  unsigned long top = ((unsigned long)&here & ~(PAGE - 1UL)) - PAGE;
+
+  // every page is one fault, and moves the guard down by a page
+  unsigned long c0 = read_cycle(), i0 = read_instret();
+  touch(top);
+  unsigned long c1 = read_cycle(), i1 = read_instret();
+  bench_report("stack_fault", PAGE, PAGES, c1 - c0, i1 - i0);
+
+  c0 = read_cycle(), i0 = read_instret();
+  touch(top);
+  c1 = read_cycle(), i1 = read_instret();
+  bench_report("stack_touch", PAGE, PAGES, c1 - c0, i1 - i0);
+
+  exit(0);
+}
@@ -0,0 +1,51 @@
+/*
+ * host file read throughput: file_pread() of an open file (served by spike_file_pread()
+ * through HTIF) across read sizes. the file is read through from the start, and again once
+ * its end is reached. it is the ELF of this app, as "make bench" builds it.
+ */
+
+#include "user/user_lib.h"
+#include "bench.h"
+
+#define BENCH_FILE "obj/bench_file"
+#define MAX_SIZE 16384
+
+static char buf[MAX_SIZE];
+
+typedef struct file_arg_t {
+  int fd;
+  unsigned long size, file_size;
+  unsigned long off;
+} file_arg;
+
+static void do_read(void *arg, unsigned long iters) {
+  file_arg *a = arg;
+  for (unsigned long i = 0; i < iters; i++) {
+    if (a->off + a->size > a->file_size) a->off = 0;
+    if (file_pread(a->fd, buf, a->size, a->off) != a->size) {
+      printu("bench_file: read of %ld bytes at %ld failed\n", a->size, a->off);
+      exit(-1);
+    }
+    a->off += a->size;
+  }
+}
+
+int main(void) {
+  int fd = file_open(BENCH_FILE);
+  if (fd < 0) {
+    printu("bench_file: can not open %s\n", BENCH_FILE);
+    exit(-1);
+  }
+
+  // the size of the file, found by reading it through
+  unsigned long file_size = 0;
+  long n;
+  while ((n = file_pread(fd, buf, MAX_SIZE, file_size)) > 0) file_size += n;
+
+  for (unsigned long size = 64; size <= MAX_SIZE && size <= file_size; size *= 4) {
+    file_arg a = {fd, size, file_size, 0};
+    bench_run("file_read", size, do_read, &a, 100);
+  }
+  file_close(fd);
+  exit(0);
+}
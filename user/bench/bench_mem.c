@@ -0,0 +1,58 @@
+/*
+ * memcpy/memset/memmove bandwidth across sizes, with the routines of util/string.c that
+ * the user links against (the scalar versions: only the kernel turns on the vector ones,
+ * which kernel/kmem_bench.c times at boot).
+ *
+ * usage: bench_mem [max size [min size]], or BENCH_MAX_SIZE and BENCH_MIN_SIZE in the
+ * environment. the sizes go up by 4 times from the min, up to MAX_SIZE.
+ */
+
+#include "user/user_lib.h"
+#include "util/string.h"
+#include "bench.h"
+
+#define MAX_SIZE 65536
+
+static char src[MAX_SIZE + 64] __attribute__((aligned(64)));
+static char dst[MAX_SIZE + 64] __attribute__((aligned(64)));
+
+typedef struct mem_arg_t {
+  unsigned long size;
+  unsigned long misalign;  // added to the source address
+} mem_arg;
+
+static void do_memcpy(void *arg, unsigned long iters) {
+  mem_arg *a = arg;
+  for (unsigned long i = 0; i < iters; i++) memcpy(dst, src + a->misalign, a->size);
+}
+
+static void do_memset(void *arg, unsigned long iters) {
+  mem_arg *a = arg;
+  for (unsigned long i = 0; i < iters; i++) memset(dst, i, a->size);
+}
+
+static void do_memmove(void *arg, unsigned long iters) {
+  mem_arg *a = arg;
+  // overlapping, dst above src: the backward copy
+  for (unsigned long i = 0; i < iters; i++) memmove(dst + 8, dst, a->size);
+}
+
+int main(int argc, char *argv[]) {
+  unsigned long max = bench_param(argc, argv, 1, "BENCH_MAX_SIZE", MAX_SIZE);
+  unsigned long min = bench_param(argc, argv, 2, "BENCH_MIN_SIZE", 16);
+  if (max > MAX_SIZE) max = MAX_SIZE;
+  if (!min) min = 1;
+  memset(src, 0x5a, sizeof(src));
+
+  for (unsigned long size = min; size <= max; size *= 4) {
+    // keep the total work about the same for all sizes
+    unsigned long iters = max * 4 / size;
+    mem_arg aligned = {size, 0}, misaligned = {size, 3};
+
+    bench_run("memcpy", size, do_memcpy, &aligned, iters);
+    bench_run("memcpy_misaligned", size, do_memcpy, &misaligned, iters);
+    bench_run("memset", size, do_memset, &aligned, iters);
+    bench_run("memmove_overlap", size, do_memmove, &aligned, iters);
+  }
+  exit(0);
+}
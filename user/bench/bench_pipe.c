@@ -0,0 +1,82 @@
+/*
+ * pipe bandwidth: 64KB through a pipe, written in whole pages (gifted to the pipe) and in
+ * half pages (copied into kernel pages). and pipe latency: a byte sent back and forth
+ * between two green threads over a pair of pipes.
+ */
+
+#include "user/user_lib.h"
+#include "user/uthread.h"
+#include "bench.h"
+
+#define PGSIZE 4096
+#define CHUNK (16 * PGSIZE)
+
+static char src[CHUNK] __attribute__((aligned(PGSIZE)));
+static char dst[CHUNK];
+static int fds[2];
+
+static void through_pipe(void *arg, unsigned long iters) {
+  long write_size = (long)arg;
+  for (unsigned long i = 0; i < iters; i++) {
+    long done = 0;
+    while (done < CHUNK) {
+      long n = write(fds[1], src + done, write_size);
+      if (n <= 0) break;
+      done += n;
+      while (read(fds[0], dst, CHUNK) > 0)
+        ;
+    }
+  }
+}
+
+#define ROUNDS 1000
+
+static int ping[2], pong[2];
+
+// read a byte from fd, yielding to the other thread while the pipe is empty
+static char recv_byte(int fd) {
+  char c;
+  while (read(fd, &c, 1) != 1) thread_yield();
+  return c;
+}
+
+static void echo(void *arg) {
+  for (int i = 0; i < ROUNDS; i++) {
+    char c = recv_byte(ping[0]);
+    write(pong[1], &c, 1);
+  }
+}
+
+static void pingpong(void) {
+  int tid = thread_create(echo, 0);
+  unsigned long c0 = read_cycle(), i0 = read_instret();
+  for (int i = 0; i < ROUNDS; i++) {
+    char c = i;
+    write(ping[1], &c, 1);
+    if (recv_byte(pong[0]) != c) {
+      printu("bench_pipe: ping-pong got a wrong byte\n");
+      exit(-1);
+    }
+  }
+  unsigned long c1 = read_cycle(), i1 = read_instret();
+  thread_join(tid);
+  bench_report("pipe_pingpong", 1, ROUNDS, c1 - c0, i1 - i0);
+}
+
+int main(void) {
+  if (pipe(fds) != 0) {
+    printu("bench_pipe: pipe() failed\n");
+    exit(-1);
+  }
+  bench_run("pipe_gift", CHUNK, through_pipe, (void *)(long)CHUNK, 100);
+  bench_run("pipe_copy", CHUNK, through_pipe, (void *)(long)(PGSIZE / 2), 100);
+  close(fds[0]);
+  close(fds[1]);
+
+  if (pipe(ping) != 0 || pipe(pong) != 0) {
+    printu("bench_pipe: pipe() failed\n");
+    exit(-1);
+  }
+  pingpong();
+  exit(0);
+}
@@ -0,0 +1,24 @@
+/*
+ * print throughput: printu() of lines of various lengths, i.e., formatting in the user,
+ * a syscall, and the HTIF console output of the kernel.
+ */
+
+#include "user/user_lib.h"
+#include "bench.h"
+
+static char line[257];
+
+static void print_line(void *arg, unsigned long iters) {
+  for (unsigned long i = 0; i < iters; i++) printu("%s\n", line);
+}
+
+int main(void) {
+  static const unsigned long sizes[] = {8, 64, 200};
+
+  for (int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    for (int i = 0; i < sizes[s]; i++) line[i] = 'a' + i % 26;
+    line[sizes[s]] = 0;
+    bench_run("print", sizes[s] + 1, print_line, 0, 100);
+  }
+  exit(0);
+}
@@ -0,0 +1,31 @@
+/*
+ * formatting speed of vsnprintf() (util/snprintf.c), without any output.
+ */
+
+#include "user/user_lib.h"
+#include "util/snprintf.h"
+#include "bench.h"
+
+static char out[256];
+
+static void fmt_literal(void *arg, unsigned long iters) {
+  for (unsigned long i = 0; i < iters; i++)
+    snprintf(out, sizeof(out), "a format string made of literal characters only\n");
+}
+
+static void fmt_decimal(void *arg, unsigned long iters) {
+  for (unsigned long i = 0; i < iters; i++)
+    snprintf(out, sizeof(out), "%d %ld %lu\n", (int)i, (long)i * 1000003, i * 99991);
+}
+
+static void fmt_mixed(void *arg, unsigned long iters) {
+  for (unsigned long i = 0; i < iters; i++)
+    snprintf(out, sizeof(out), "[%8lx] %-10s %p %c\n", i, "name", out, 'x');
+}
+
+int main(void) {
+  bench_run("snprintf_literal", 0, fmt_literal, 0, 2000);
+  bench_run("snprintf_decimal", 0, fmt_decimal, 0, 2000);
+  bench_run("snprintf_mixed", 0, fmt_mixed, 0, 2000);
+  exit(0);
+}
@@ -0,0 +1,106 @@
+/*
+ * shared-memory rings (user/uring.c): ping-pong latency over a pair of SPSC rings, and the
+ * throughput of SPSC and MPMC rings. lab1 runs one process, so the two sides are green
+ * threads (user/uthread.c). the blocking calls yield to each other when a ring is empty or
+ * full; the throughput is also measured with the non-blocking ones, polled with yields.
+ */
+
+#include "user/user_lib.h"
+#include "user/uthread.h"
+#include "user/uring.h"
+#include "bench.h"
+
+#define ROUNDS 10000
+#define MESSAGES 100000
+#define RING_CAP 256
+
+static spsc_ring *ping, *pong, *stream;
+static mpmc_ring *mstream;
+
+static void echo(void *arg) {
+  for (int i = 0; i < ROUNDS; i++) spsc_push(pong, spsc_pop(ping));
+}
+
+static void spsc_producer(void *arg) {
+  for (uring_msg i = 0; i < MESSAGES; i++) spsc_push(stream, i);
+}
+
+static void spsc_try_producer(void *arg) {
+  for (uring_msg i = 0; i < MESSAGES; i++)
+    while (spsc_try_push(stream, i) != 0) thread_yield();
+}
+
+static void mpmc_producer(void *arg) {
+  for (uring_msg i = 0; i < MESSAGES; i++) mpmc_push(mstream, i);
+}
+
+static void mpmc_try_producer(void *arg) {
+  for (uring_msg i = 0; i < MESSAGES; i++)
+    while (mpmc_try_push(mstream, i) != 0) thread_yield();
+}
+
+static void check(const char *name, uring_msg got, uring_msg want) {
+  if (got == want) return;
+  printu("bench_ring: %s got %ld instead of %ld\n", name, got, want);
+  exit(-1);
+}
+
+int main(void) {
+  ping = spsc_open("bench_ping", RING_CAP);
+  pong = spsc_open("bench_pong", RING_CAP);
+  stream = spsc_open("bench_spsc", RING_CAP);
+  mstream = mpmc_open("bench_mpmc", RING_CAP);
+  if (!ping || !pong || !stream || !mstream) {
+    printu("bench_ring: no shared memory\n");
+    exit(-1);
+  }
+
+  int tid = thread_create(echo, 0);
+  unsigned long c0 = read_cycle(), i0 = read_instret();
+  for (int i = 0; i < ROUNDS; i++) {
+    spsc_push(ping, i);
+    check("spsc_pingpong", spsc_pop(pong), i);
+  }
+  unsigned long c1 = read_cycle(), i1 = read_instret();
+  thread_join(tid);
+  bench_report("spsc_pingpong", RING_CAP, ROUNDS, c1 - c0, i1 - i0);
+
+  tid = thread_create(spsc_producer, 0);
+  c0 = read_cycle(), i0 = read_instret();
+  for (uring_msg i = 0; i < MESSAGES; i++) check("spsc_throughput", spsc_pop(stream), i);
+  c1 = read_cycle(), i1 = read_instret();
+  thread_join(tid);
+  bench_report("spsc_throughput", RING_CAP, MESSAGES, c1 - c0, i1 - i0);
+
+  tid = thread_create(spsc_try_producer, 0);
+  c0 = read_cycle(), i0 = read_instret();
+  for (uring_msg i = 0; i < MESSAGES; i++) {
+    uring_msg m;
+    while (spsc_try_pop(stream, &m) != 0) thread_yield();
+    check("spsc_try_throughput", m, i);
+  }
+  c1 = read_cycle(), i1 = read_instret();
+  thread_join(tid);
+  bench_report("spsc_try_throughput", RING_CAP, MESSAGES, c1 - c0, i1 - i0);
+
+  // one producer and one consumer keep the order
+  tid = thread_create(mpmc_producer, 0);
+  c0 = read_cycle(), i0 = read_instret();
+  for (uring_msg i = 0; i < MESSAGES; i++) check("mpmc_throughput", mpmc_pop(mstream), i);
+  c1 = read_cycle(), i1 = read_instret();
+  thread_join(tid);
+  bench_report("mpmc_throughput", RING_CAP, MESSAGES, c1 - c0, i1 - i0);
+
+  tid = thread_create(mpmc_try_producer, 0);
+  c0 = read_cycle(), i0 = read_instret();
+  for (uring_msg i = 0; i < MESSAGES; i++) {
+    uring_msg m;
+    while (mpmc_try_pop(mstream, &m) != 0) thread_yield();
+    check("mpmc_try_throughput", m, i);
+  }
+  c1 = read_cycle(), i1 = read_instret();
+  thread_join(tid);
+  bench_report("mpmc_try_throughput", RING_CAP, MESSAGES, c1 - c0, i1 - i0);
+
+  exit(0);
+}
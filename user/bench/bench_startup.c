@@ -0,0 +1,13 @@
+/*
+ * app startup time: the counters start from zero at reset, so their values at the first
+ * line of main() are the cost of booting PKE and loading this app.
+ */
+
+#include "user/user_lib.h"
+#include "bench.h"
+
+int main(void) {
+  unsigned long cycles = read_cycle(), instret = read_instret();
+  bench_report("startup", 0, 1, cycles, instret);
+  exit(0);
+}
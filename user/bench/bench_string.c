@@ -0,0 +1,37 @@
+/*
+ * strlen/strcmp/strcpy of util/string.c on strings of various lengths.
+ */
+
+#include "user/user_lib.h"
+#include "util/string.h"
+#include "bench.h"
+
+#define MAX_LEN 4096
+
+static char s1[MAX_LEN + 1], s2[MAX_LEN + 1], s3[MAX_LEN + 1];
+static volatile unsigned long sink;
+
+static void do_strlen(void *arg, unsigned long iters) {
+  for (unsigned long i = 0; i < iters; i++) sink += strlen(s1);
+}
+
+static void do_strcmp(void *arg, unsigned long iters) {
+  for (unsigned long i = 0; i < iters; i++) sink += strcmp(s1, s2);
+}
+
+static void do_strcpy(void *arg, unsigned long iters) {
+  for (unsigned long i = 0; i < iters; i++) strcpy(s3, s1);
+}
+
+int main(void) {
+  for (unsigned long len = 16; len <= MAX_LEN; len *= 4) {
+    for (int i = 0; i < len; i++) s1[i] = s2[i] = 'a' + i % 26;
+    s1[len] = s2[len] = 0;
+    unsigned long iters = MAX_LEN * 16 / len;
+
+    bench_run("strlen", len, do_strlen, 0, iters);
+    bench_run("strcmp", len, do_strcmp, 0, iters);
+    bench_run("strcpy", len, do_strcpy, 0, iters);
+  }
+  exit(0);
+}
@@ -0,0 +1,29 @@
+/*
+ * null syscall: the cost of a round trip through the kernel. yield() does no work in
+ * lab1, where the only process is given the cpu back right away. against it, what the
+ * kernel info page saves: reads of the time and of kernel state without a syscall.
+ */
+
+#include "user/user_lib.h"
+#include "bench.h"
+
+static void null_syscall(void *arg, unsigned long iters) {
+  for (unsigned long i = 0; i < iters; i++) yield();
+}
+
+static void clock_read(void *arg, unsigned long iters) {
+  struct timespec ts;
+  for (unsigned long i = 0; i < iters; i++) clock_gettime(CLOCK_MONOTONIC, &ts);
+}
+
+static void kinfo_read(void *arg, unsigned long iters) {
+  kinfo k;
+  for (unsigned long i = 0; i < iters; i++) kinfo_snapshot(&k);
+}
+
+int main(void) {
+  bench_run("null_syscall", 0, null_syscall, 0, 10000);
+  bench_run("clock_gettime", 0, clock_read, 0, 10000);
+  bench_run("kinfo_snapshot", 0, kinfo_read, 0, 10000);
+  exit(0);
+}
@@ -0,0 +1,45 @@
+/*
+ * green thread switch cost (user/uthread.c): two threads yielding to each other, and a
+ * channel ping-pong between them.
+ */
+
+#include "user/user_lib.h"
+#include "user/uthread.h"
+#include "bench.h"
+
+#define ROUNDS 10000
+
+static void yielder(void *arg) {
+  for (int i = 0; i < ROUNDS; i++) thread_yield();
+}
+
+static long ping_buf[1], pong_buf[1];
+static chan ping, pong;
+
+static void echo(void *arg) {
+  for (int i = 0; i < ROUNDS; i++) chan_send(&pong, chan_recv(&ping));
+}
+
+int main(void) {
+  // every thread_yield() of either thread is one switch
+  int tid = thread_create(yielder, 0);
+  unsigned long c0 = read_cycle(), i0 = read_instret();
+  for (int i = 0; i < ROUNDS; i++) thread_yield();
+  unsigned long c1 = read_cycle(), i1 = read_instret();
+  thread_join(tid);
+  bench_report("uthread_switch", 0, 2 * ROUNDS, c1 - c0, i1 - i0);
+
+  chan_init(&ping, ping_buf, 1);
+  chan_init(&pong, pong_buf, 1);
+  tid = thread_create(echo, 0);
+  c0 = read_cycle(), i0 = read_instret();
+  for (int i = 0; i < ROUNDS; i++) {
+    chan_send(&ping, i);
+    chan_recv(&pong);
+  }
+  c1 = read_cycle(), i1 = read_instret();
+  thread_join(tid);
+  bench_report("uthread_chan_roundtrip", 0, ROUNDS, c1 - c0, i1 - i0);
+
+  exit(0);
+}
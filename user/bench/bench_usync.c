@@ -0,0 +1,115 @@
+/*
+ * user-level synchronization (user/usync.c) contended between green threads: a mutex held
+ * across yields, a bounded buffer on a condition variable, and one on semaphores. each
+ * case checks its result, and the app exits with -1 if one is wrong.
+ */
+
+#include "user/user_lib.h"
+#include "user/uthread.h"
+#include "user/usync.h"
+#include "bench.h"
+
+#define WORKERS 4
+#define ITERS 1000
+#define ITEMS 4000
+#define SLOTS 8
+
+static umutex lock;
+static long counter;
+
+static void mutex_worker(void *arg) {
+  for (int i = 0; i < ITERS; i++) {
+    umutex_lock(&lock);
+    // yield inside the critical section, so that the others find the mutex taken
+    long v = counter;
+    thread_yield();
+    counter = v + 1;
+    umutex_unlock(&lock);
+  }
+}
+
+// a bounded buffer of SLOTS items
+static long slots[SLOTS];
+static int head, count;
+static ucond not_empty, not_full;
+
+static void cond_producer(void *arg) {
+  for (long i = 1; i <= ITEMS; i++) {
+    umutex_lock(&lock);
+    while (count == SLOTS) ucond_wait(&not_full, &lock);
+    slots[(head + count++) % SLOTS] = i;
+    ucond_signal(&not_empty);
+    umutex_unlock(&lock);
+  }
+}
+
+static long cond_consume(void) {
+  umutex_lock(&lock);
+  while (count == 0) ucond_wait(&not_empty, &lock);
+  long v = slots[head];
+  head = (head + 1) % SLOTS;
+  count--;
+  ucond_signal(&not_full);
+  umutex_unlock(&lock);
+  return v;
+}
+
+static usem filled, free_slots;
+static int sem_tail;
+
+static void sem_producer(void *arg) {
+  for (long i = 1; i <= ITEMS; i++) {
+    usem_wait(&free_slots);
+    slots[sem_tail] = i;
+    sem_tail = (sem_tail + 1) % SLOTS;
+    usem_post(&filled);
+  }
+}
+
+static void check(const char *name, long got, long want) {
+  if (got == want) return;
+  printu("bench_usync: %s gave %ld instead of %ld\n", name, got, want);
+  exit(-1);
+}
+
+int main(void) {
+  int tids[WORKERS];
+  unsigned long c0 = read_cycle(), i0 = read_instret();
+  for (int i = 0; i < WORKERS; i++) tids[i] = thread_create(mutex_worker, 0);
+  for (int i = 0; i < WORKERS; i++) thread_join(tids[i]);
+  unsigned long c1 = read_cycle(), i1 = read_instret();
+  check("umutex", counter, WORKERS * ITERS);
+  bench_report("umutex_contended", WORKERS, WORKERS * ITERS, c1 - c0, i1 - i0);
+
+  // the sum of 1 .. ITEMS, in order
+  long want = (long)ITEMS * (ITEMS + 1) / 2, sum = 0, last = 0;
+  int tid = thread_create(cond_producer, 0);
+  c0 = read_cycle(), i0 = read_instret();
+  for (int i = 0; i < ITEMS; i++) {
+    long v = cond_consume();
+    if (v != last + 1) check("ucond order", v, last + 1);
+    sum += last = v;
+  }
+  c1 = read_cycle(), i1 = read_instret();
+  thread_join(tid);
+  check("ucond", sum, want);
+  bench_report("ucond_bounded_buffer", SLOTS, ITEMS, c1 - c0, i1 - i0);
+
+  usem_init(&filled, 0);
+  usem_init(&free_slots, SLOTS);
+  sum = 0;
+  tid = thread_create(sem_producer, 0);
+  c0 = read_cycle(), i0 = read_instret();
+  for (int i = 0; i < ITEMS; i++) {
+    usem_wait(&filled);
+    sum += slots[i % SLOTS];
+    usem_post(&free_slots);
+  }
+  c1 = read_cycle(), i1 = read_instret();
+  thread_join(tid);
+  check("usem", sum, want);
+  bench_report("usem_bounded_buffer", SLOTS, ITEMS, c1 - c0, i1 - i0);
+
+  usync_print_stats();
+  exit(0);
+}
@@ -0,0 +1,188 @@
+/*
+ * util/string.c against byte-at-a-time references: memcpy, memset, memmove (overlapping
+ * both ways), memcmp, strlen, strcmp and strcpy, for every source and destination
+ * alignment 0-7 and every length 0 to MAXLEN. the bytes around the destination are checked
+ * too, so that writes out of bounds show up. the word-at-a-time string paths, safestrcpy()
+ * included, are checked again on the bytes that are the edge cases of their has-zero-byte
+ * test. on a hart with V, all of it runs again with the vector versions of the routines,
+ * which the kernel lets the app use (see kernel/vector.c). the app exits with -1 if any
+ * check fails.
+ */
+
+#include "user/user_lib.h"
+#include "util/string.h"
+
+#define MAXLEN 72
+#define PAD 16
+#define SIZE (PAD + 16 + MAXLEN + PAD)
+
+static unsigned char a[SIZE] __attribute__((aligned(8)));
+static unsigned char b[SIZE] __attribute__((aligned(8)));
+static unsigned char ref[SIZE] __attribute__((aligned(8)));
+
+static int failures;
+// the versions of the routines under test
+static const char *version = "scalar";
+
+static void fail(const char *name, int sa, int da, int len) {
+  if (failures++ < 16)
+    printu("test_string: %s (%s) fails, src %d dst %d len %d\n", name, version, sa, da, len);
+}
+
+// non-zero bytes, with the top bit set in some, so that signed comparisons would show
+static void fill(unsigned char *p, int seed) {
+  for (int i = 0; i < SIZE; i++) p[i] = (unsigned char)(i * 13 + seed) | 1;
+}
+
+static int same(const unsigned char *p, const unsigned char *q) {
+  for (int i = 0; i < SIZE; i++)
+    if (p[i] != q[i]) return 0;
+  return 1;
+}
+
+static int sign(int v) { return v > 0 ? 1 : v < 0 ? -1 : 0; }
+
+static int ref_strcmp(const unsigned char *s, const unsigned char *t) {
+  for (; *s && *s == *t; s++, t++)
+    ;
+  return sign(*s - *t);
+}
+
+static void test_mem(void) {
+  for (int sa = 0; sa < 8; sa++)
+    for (int da = 0; da < 8; da++)
+      for (int len = 0; len <= MAXLEN; len++) {
+        unsigned char *src = a + PAD + sa, *dst = b + PAD + da;
+
+        fill(a, 1);
+        fill(b, 2);
+        fill(ref, 2);
+        for (int i = 0; i < len; i++) ref[PAD + da + i] = src[i];
+        if (memcpy(dst, src, len) != dst || !same(b, ref)) fail("memcpy", sa, da, len);
+
+        fill(b, 2);
+        fill(ref, 2);
+        for (int i = 0; i < len; i++) ref[PAD + da + i] = 0xa5;
+        if (memset(dst, 0xa5, len) != dst || !same(b, ref)) fail("memset", sa, da, len);
+
+        // equal, then differing at the last byte, both ways
+        fill(b, 1);
+        if (memcmp(b + PAD + sa, src, len) != 0) fail("memcmp equal", sa, da, len);
+        if (len && sa == da) {
+          b[PAD + sa + len - 1] ^= 0x80;
+          int want = sign(b[PAD + sa + len - 1] - src[len - 1]);
+          if (sign(memcmp(b + PAD + sa, src, len)) != want) fail("memcmp", sa, da, len);
+          if (sign(memcmp(src, b + PAD + sa, len)) != -want) fail("memcmp", sa, da, len);
+        }
+      }
+}
+
+// the source and destination in the same buffer, up to 15 bytes apart either way
+static void test_memmove(void) {
+  unsigned char tmp[MAXLEN];
+  for (int s = 0; s < 16; s++)
+    for (int d = 0; d < 16; d++)
+      for (int len = 0; len <= MAXLEN; len++) {
+        fill(a, 3);
+        fill(ref, 3);
+        for (int i = 0; i < len; i++) tmp[i] = ref[PAD + s + i];
+        for (int i = 0; i < len; i++) ref[PAD + d + i] = tmp[i];
+        if (memmove(a + PAD + d, a + PAD + s, len) != a + PAD + d || !same(a, ref))
+          fail(d > s ? "memmove backward" : "memmove forward", s, d, len);
+      }
+}
+
+static void test_str(void) {
+  for (int sa = 0; sa < 8; sa++)
+    for (int da = 0; da < 8; da++)
+      for (int len = 0; len <= MAXLEN; len++) {
+        unsigned char *src = a + PAD + sa, *dst = b + PAD + da;
+        fill(a, 4);
+        src[len] = 0;
+
+        if (da == 0 && strlen((char *)src) != len) fail("strlen", sa, da, len);
+
+        fill(b, 5);
+        fill(ref, 5);
+        for (int i = 0; i <= len; i++) ref[PAD + da + i] = src[i];
+        if (strcpy((char *)dst, (char *)src) != (char *)dst || !same(b, ref))
+          fail("strcpy", sa, da, len);
+
+        // dst holds the same string now: equal, and differing at every position k
+        if (strcmp((char *)dst, (char *)src) != 0) fail("strcmp equal", sa, da, len);
+        for (int k = 0; k <= len; k++) {
+          unsigned char saved = dst[k];
+          dst[k] = k == len ? 0x42 : dst[k] ^ 0x80;  // past the end: dst is the longer one
+          int want = ref_strcmp(dst, src);
+          if (sign(strcmp((char *)dst, (char *)src)) != want ||
+              sign(strcmp((char *)src, (char *)dst)) != -want)
+            fail("strcmp", sa, da, len);
+          dst[k] = saved;
+        }
+      }
+}
+
+// the bytes next to the borrows and the high bits that HASZERO() in util/string.c works with
+static const unsigned char edge_bytes[] = {0x01, 0x7f, 0x80, 0xfe, 0xff};
+
+//
+// strings of one edge byte, with the source and destination equally aligned, so that the
+// word-at-a-time paths are taken. over the alignments and lengths, the NUL falls at every
+// byte of an aligned word (the last one included), after unaligned heads of 0-7 bytes.
+//
+static void test_word_edges(void) {
+  for (int e = 0; e < sizeof(edge_bytes); e++)
+    for (int al = 0; al < 8; al++)
+      for (int len = 0; len <= 3 * 8; len++) {
+        unsigned char *src = a + PAD + al, *dst = b + PAD + al;
+        for (int i = 0; i < SIZE; i++) a[i] = edge_bytes[e];
+        src[len] = 0;
+
+        if (strlen((char *)src) != len) fail("strlen of edge bytes", al, al, len);
+
+        fill(b, 6);
+        fill(ref, 6);
+        for (int i = 0; i <= len; i++) ref[PAD + al + i] = src[i];
+        if (strcpy((char *)dst, (char *)src) != (char *)dst || !same(b, ref))
+          fail("strcpy of edge bytes", al, al, len);
+
+        // equal, then dst one byte longer: the NUL of src ends the comparison mid-word
+        if (strcmp((char *)dst, (char *)src) != 0) fail("strcmp of edge bytes", al, al, len);
+        dst[len] = edge_bytes[e];
+        if (sign(strcmp((char *)dst, (char *)src)) != 1 ||
+            sign(strcmp((char *)src, (char *)dst)) != -1)
+          fail("strcmp of edge bytes", al, al, len);
+
+        // every limit around the length: min(len, n - 1) bytes, and the NUL
+        for (int n = 0; n <= len + 2; n++) {
+          fill(b, 6);
+          fill(ref, 6);
+          if (n > 0) {
+            int copy = len < n - 1 ? len : n - 1;
+            for (int i = 0; i < copy; i++) ref[PAD + al + i] = src[i];
+            ref[PAD + al + copy] = 0;
+          }
+          if (safestrcpy((char *)dst, (char *)src, n) != (char *)dst || !same(b, ref))
+            fail("safestrcpy of edge bytes", al, n, len);
+        }
+      }
+}
+
+static void test_all(void) {
+  test_mem();
+  test_memmove();
+  test_str();
+  test_word_edges();
+}
+
+int main(void) {
+  test_all();
+  if (getauxval(AT_HWCAP) & (1 << ('V' - 'A'))) {
+    // string_enable_vector() is defined in util/string.c
+    version = "vector";
+    string_enable_vector();
+    test_all();
+  }
+  printu("test_string: %d failures\n", failures);
+  exit(failures ? -1 : 0);
+}
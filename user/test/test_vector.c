@@ -0,0 +1,37 @@
+/*
+ * lazy vector state (kernel/vector.c): the first vector instruction of the app traps, while
+ * the kernel has the vector unit for its own string routines, and the kernel hands the unit
+ * over to the app. the vector registers and vl must then stay as the app left them across
+ * syscalls. the app exits with -1 if they do not, and with 0 at once on a hart without V.
+ */
+
+#include "user/user_lib.h"
+
+#define VEC_ASM(insns) ".option push\n.option arch, +v\n" insns "\n.option pop\n"
+
+static unsigned long src[2] = {0x0123456789abcdefUL, 0xfedcba9876543210UL};
+static unsigned long dst[2];
+
+int main(void) {
+  if (!(getauxval(AT_HWCAP) & (1 << ('V' - 'A')))) {
+    printu("test_vector: no V extension, nothing to test\n");
+    exit(0);
+  }
+
+  // the first vector instruction, which takes the vector unit
+  unsigned long vl, vl_after;
+  asm volatile(VEC_ASM("vsetivli %0, 2, e64, m1, ta, ma") : "=r"(vl));
+  asm volatile(VEC_ASM("vle64.v v1, (%0)") : : "r"(src) : "memory");
+
+  // syscalls, with memcpy() and friends in the kernel
+  yield();
+  printu("test_vector: vl is %ld\n", vl);
+
+  asm volatile(VEC_ASM("csrr %0, vl") : "=r"(vl_after));
+  asm volatile(VEC_ASM("vse64.v v1, (%0)") : : "r"(dst) : "memory");
+  if (vl != 2 || vl_after != vl || dst[0] != src[0] || dst[1] != src[1]) {
+    printu("test_vector: the vector state changed across syscalls\n");
+    exit(-1);
+  }
+  exit(0);
+}
@@ -0,0 +1,179 @@
+/*
+ * rings in shared memory, see uring.h. the first process to open a ring initializes it;
+ * shared memory starts zero-filled, so state tells whether that has been done.
+ */
+
+#include "uring.h"
+#include "user_lib.h"
+#include "uthread.h"
+
+#define URING_EMPTY 0
+#define URING_INITIALIZING 1
+#define URING_READY 2
+
+// timer ticks to sleep on a full or empty ring before checking again
+#define URING_SLEEP_TICKS 10
+
+#define load_acquire(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define store_release(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+
+//
+// map the ring, whose first word is its state. *created is set for the process that
+// creates it, which must then set it up and make it URING_READY; the others wait for that.
+//
+static void *ring_open(const char *name, unsigned long bytes, unsigned long cap, int *created) {
+  if (cap == 0 || (cap & (cap - 1)) != 0) return 0;
+  int *state = shm_open(name, bytes);
+  if (!state) return 0;
+
+  int expected = URING_EMPTY;
+  *created = __atomic_compare_exchange_n(state, &expected, URING_INITIALIZING, 0,
+                                         __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE);
+  if (!*created)
+    while (load_acquire(state) != URING_READY) yield();
+  return state;
+}
+
+//
+// sleep on the 32-bit futex word of *index (its low half), as long as it still holds seen.
+// waiting is set first, so the other side sees it before it moves the index and wakes us.
+//
+// the other side may be a green thread (user/uthread.c) of this process, which runs only
+// when we yield, and not while futex_wait() stops the process: yield while others can run.
+//
+static void ring_sleep(int *waiting, unsigned long *index, unsigned long seen) {
+  if (thread_runnable() > 1) {
+    thread_yield();
+    return;
+  }
+  store_release(waiting, 1);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (load_acquire(index) == seen) futex_wait((int *)index, (int)seen, URING_SLEEP_TICKS);
+  store_release(waiting, 0);
+}
+
+static void ring_wake(int *waiting, unsigned long *index) {
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (load_acquire(waiting)) futex_wake((int *)index, 1 << 30);
+}
+
+spsc_ring *spsc_open(const char *name, unsigned long cap) {
+  int created;
+  spsc_ring *r = ring_open(name, sizeof(spsc_ring) + cap * sizeof(uring_msg), cap, &created);
+  if (r && created) {
+    r->mask = cap - 1;
+    store_release(&r->state, URING_READY);
+  }
+  return r;
+}
+
+int spsc_try_push(spsc_ring *r, uring_msg m) {
+  unsigned long tail = r->tail;
+  // look at the head of the consumer only when the cached one says the ring is full
+  if (tail - r->cached_head > r->mask) {
+    r->cached_head = load_acquire(&r->head);
+    if (tail - r->cached_head > r->mask) return -1;
+  }
+  r->slots[tail & r->mask] = m;
+  store_release(&r->tail, tail + 1);
+  return 0;
+}
+
+int spsc_try_pop(spsc_ring *r, uring_msg *m) {
+  unsigned long head = r->head;
+  if (head == r->cached_tail) {
+    r->cached_tail = load_acquire(&r->tail);
+    if (head == r->cached_tail) return -1;
+  }
+  *m = r->slots[head & r->mask];
+  store_release(&r->head, head + 1);
+  return 0;
+}
+
+void spsc_push(spsc_ring *r, uring_msg m) {
+  while (spsc_try_push(r, m) != 0) ring_sleep(&r->prod_waiting, &r->head, r->cached_head);
+  ring_wake(&r->cons_waiting, &r->tail);
+}
+
+uring_msg spsc_pop(spsc_ring *r) {
+  uring_msg m;
+  while (spsc_try_pop(r, &m) != 0) ring_sleep(&r->cons_waiting, &r->tail, r->cached_tail);
+  ring_wake(&r->prod_waiting, &r->head);
+  return m;
+}
+
+mpmc_ring *mpmc_open(const char *name, unsigned long cap) {
+  int created;
+  mpmc_ring *r = ring_open(name, sizeof(mpmc_ring) + cap * sizeof(mpmc_slot), cap, &created);
+  if (r && created) {
+    r->mask = cap - 1;
+    for (unsigned long i = 0; i < cap; i++) r->slots[i].seq = i;
+    store_release(&r->state, URING_READY);
+  }
+  return r;
+}
+
+int mpmc_try_push(mpmc_ring *r, uring_msg m) {
+  unsigned long pos = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+  mpmc_slot *s;
+  for (;;) {
+    s = &r->slots[pos & r->mask];
+    long dif = (long)(load_acquire(&s->seq) - pos);
+    if (dif == 0) {
+      // our turn at this slot, if no other producer claims pos first
+      if (__atomic_compare_exchange_n(&r->tail, &pos, pos + 1, 1, __ATOMIC_RELAXED,
+                                      __ATOMIC_RELAXED))
+        break;
+    } else if (dif < 0) {
+      // the consumer of the previous round has not taken the slot: full
+      return -1;
+    } else {
+      pos = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+    }
+  }
+  s->msg = m;
+  store_release(&s->seq, pos + 1);
+  return 0;
+}
+
+int mpmc_try_pop(mpmc_ring *r, uring_msg *m) {
+  unsigned long pos = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+  mpmc_slot *s;
+  for (;;) {
+    s = &r->slots[pos & r->mask];
+    long dif = (long)(load_acquire(&s->seq) - (pos + 1));
+    if (dif == 0) {
+      if (__atomic_compare_exchange_n(&r->head, &pos, pos + 1, 1, __ATOMIC_RELAXED,
+                                      __ATOMIC_RELAXED))
+        break;
+    } else if (dif < 0) {
+      return -1;
+    } else {
+      pos = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+    }
+  }
+  *m = s->msg;
+  // hand the slot to the producer of the next round
+  store_release(&s->seq, pos + r->mask + 1);
+  return 0;
+}
+
+void mpmc_push(mpmc_ring *r, uring_msg m) {
+  for (;;) {
+    unsigned long head = load_acquire(&r->head);
+    if (mpmc_try_push(r, m) == 0) break;
+    ring_sleep(&r->prod_waiting, &r->head, head);
+  }
+  ring_wake(&r->cons_waiting, &r->tail);
+}
+
+uring_msg mpmc_pop(mpmc_ring *r) {
+  uring_msg m;
+  for (;;) {
+    unsigned long tail = load_acquire(&r->tail);
+    if (mpmc_try_pop(r, &m) == 0) break;
+    ring_sleep(&r->cons_waiting, &r->tail, tail);
+  }
+  ring_wake(&r->prod_waiting, &r->head);
+  return m;
+}
@@ -0,0 +1,69 @@
+/*
+ * lock-free rings of 64-bit messages in named shared memory (see shm_open() in
+ * user_lib.h), for processes to pass data to each other without a syscall. the indices of
+ * the two sides sit on separate cache lines, so a message costs a cache-line transfer.
+ * the blocking calls sleep on a futex when the ring is empty or full, or yield to the other
+ * green threads of the process, if any can run.
+ */
+#ifndef _URING_H_
+#define _URING_H_
+
+#define URING_CACHELINE 64
+
+typedef unsigned long uring_msg;
+
+// single producer, single consumer
+typedef struct spsc_ring_t {
+  // constant once state is URING_READY
+  int state;
+  int pad0;
+  unsigned long mask;  // capacity - 1
+  // set by a side about to sleep on the index the other side advances
+  int prod_waiting, cons_waiting;
+
+  // the consumer side: next slot to read, and the last tail it saw
+  unsigned long head __attribute__((aligned(URING_CACHELINE)));
+  unsigned long cached_tail;
+  // the producer side: next slot to write, and the last head it saw
+  unsigned long tail __attribute__((aligned(URING_CACHELINE)));
+  unsigned long cached_head;
+
+  uring_msg slots[] __attribute__((aligned(URING_CACHELINE)));
+} spsc_ring;
+
+// multiple producers and consumers (Vyukov's bounded queue). the seq of a slot tells whose
+// turn it is: pos for the producer of position pos, pos + 1 for its consumer.
+typedef struct mpmc_slot_t {
+  unsigned long seq;
+  uring_msg msg;
+} mpmc_slot;
+
+typedef struct mpmc_ring_t {
+  int state;
+  int pad0;
+  unsigned long mask;
+  int prod_waiting, cons_waiting;
+
+  unsigned long head __attribute__((aligned(URING_CACHELINE)));
+  unsigned long tail __attribute__((aligned(URING_CACHELINE)));
+
+  mpmc_slot slots[] __attribute__((aligned(URING_CACHELINE)));
+} mpmc_ring;
+
+// open the ring called name, creating it with cap (a power of 2) slots if needed.
+// returns 0 on failure.
+spsc_ring *spsc_open(const char *name, unsigned long cap);
+// 0 on success, -1 if the ring is full (push) or empty (pop)
+int spsc_try_push(spsc_ring *r, uring_msg m);
+int spsc_try_pop(spsc_ring *r, uring_msg *m);
+// wait while the ring is full or empty
+void spsc_push(spsc_ring *r, uring_msg m);
+uring_msg spsc_pop(spsc_ring *r);
+
+mpmc_ring *mpmc_open(const char *name, unsigned long cap);
+int mpmc_try_push(mpmc_ring *r, uring_msg m);
+int mpmc_try_pop(mpmc_ring *r, uring_msg *m);
+void mpmc_push(mpmc_ring *r, uring_msg m);
+uring_msg mpmc_pop(mpmc_ring *r);
+
+#endif
@@ -9,16 +9,17 @@
 #include "util/types.h"
 #include "util/snprintf.h"
 #include "kernel/syscall.h"
+#include "kernel/hpm.h"
 
-int do_user_call(uint64 sysnum, uint64 a1, uint64 a2, uint64 a3, uint64 a4, uint64 a5, uint64 a6,
-                 uint64 a7) {
-  int ret;
+long do_user_call(uint64 sysnum, uint64 a1, uint64 a2, uint64 a3, uint64 a4, uint64 a5, uint64 a6,
+                  uint64 a7) {
+  long ret;
 
   // before invoking the syscall, arguments of do_user_call are already loaded into the argument
   // registers (a0-a7) of our (emulated) risc-v machine.
   asm volatile(
       "ecall\n"
-      "sw a0, %0"  // returns a 32-bit value
+      "sd a0, %0"  // the full register, as shm_open() returns an address
       : "=m"(ret)
       :
       : "memory");
@@ -43,9 +44,199 @@ int printu(const char* s, ...) {
   return do_user_call(SYS_user_print, (uint64)buf, n, 0, 0, 0, 0, 0);
 }
 
+char** environ;
+// the auxiliary vector from the kernel, see kernel/auxv.h
+static unsigned long* auxv;
+
+int main(int argc, char* argv[], char* envp[]);
+
+//
+// called by _start (user/crt0.S) with the initial sp of the application, where the kernel
+// put argc, argv[], envp[] and the auxiliary vector
+//
+void start_main(unsigned long* sp) {
+  int argc = sp[0];
+  char** argv = (char**)(sp + 1);
+  environ = argv + argc + 1;
+
+  char** e = environ;
+  while (*e) e++;
+  auxv = (unsigned long*)(e + 1);
+
+  exit(main(argc, argv, environ));
+}
+
+char* getenv(const char* name) {
+  for (char** e = environ; *e; e++) {
+    const char *n = name, *s = *e;
+    while (*n && *n == *s) n++, s++;
+    if (!*n && *s == '=') return (char*)s + 1;
+  }
+  return 0;
+}
+
+unsigned long getauxval(unsigned long type) {
+  for (unsigned long* a = auxv; a[0] != AT_NULL; a += 2)
+    if (a[0] == type) return a[1];
+  return 0;
+}
+
+const kinfo* kinfo_page(void) {
+  static const kinfo* k;
+  if (!k) k = (const kinfo*)getauxval(AT_PKE_KINFO);
+  return k;
+}
+
+void kinfo_snapshot(kinfo* k) {
+  const kinfo* page = kinfo_page();
+  uint64 seq;
+  do {
+    seq = kinfo_read_begin(page);
+    *k = *page;
+  } while (kinfo_read_retry(page, seq));
+}
+
+int getpid(void) { return kinfo_page()->pid; }
+
+int gethart(void) { return kinfo_page()->hart; }
+
+//
+// the vDSO way: scale the time counter with the calibration of the kernel, no syscall
+//
+int clock_gettime(int clock, struct timespec* ts) {
+  if (clock != CLOCK_REALTIME && clock != CLOCK_MONOTONIC) return -1;
+
+  const kinfo* k = kinfo_page();
+  uint64 seq, base, mult, shift;
+  do {
+    seq = kinfo_read_begin(k);
+    base = k->time_base;
+    mult = k->ns_mult;
+    shift = k->ns_shift;
+  } while (kinfo_read_retry(k, seq));
+
+  uint64 ns = (unsigned __int128)(read_time() - base) * mult >> shift;
+  ts->tv_sec = ns / 1000000000;
+  ts->tv_nsec = ns % 1000000000;
+  return 0;
+}
+
 //
 // applications need to call exit to quit execution.
 //
 int exit(int code) {
   return do_user_call(SYS_user_exit, code, 0, 0, 0, 0, 0, 0); 
 }
+
+//
+// save the kernel trace rings to a host file, decode it with tools/trace_decode.py
+//
+int trace_dump(const char* path) {
+  return do_user_call(SYS_user_trace_dump, (uint64)path, 0, 0, 0, 0, 0, 0);
+}
+
+//
+// give up the cpu
+//
+int yield(void) {
+  return do_user_call(SYS_user_yield, 0, 0, 0, 0, 0, 0, 0);
+}
+
+//
+// read host files, see user_lib.h
+//
+int file_open(const char* path) {
+  return do_user_call(SYS_user_file_open, (uint64)path, 0, 0, 0, 0, 0, 0);
+}
+
+long file_pread(int fd, void* buf, unsigned long n, unsigned long off) {
+  return do_user_call(SYS_user_file_pread, fd, (uint64)buf, n, off, 0, 0, 0);
+}
+
+int file_close(int fd) {
+  return do_user_call(SYS_user_file_close, fd, 0, 0, 0, 0, 0, 0);
+}
+
+//
+// the futex syscalls, for the slow paths of user/usync.c
+//
+int futex_wait(int* addr, int expected, unsigned long timeout) {
+  return do_user_call(SYS_user_futex_wait, (uint64)addr, (uint32)expected, timeout, 0, 0, 0, 0);
+}
+
+int futex_wake(int* addr, int n) {
+  return do_user_call(SYS_user_futex_wake, (uint64)addr, n, 0, 0, 0, 0, 0);
+}
+
+//
+// named shared memory, see user_lib.h
+//
+void* shm_open(const char* name, unsigned long size) {
+  long addr = do_user_call(SYS_user_shm_open, (uint64)name, size, 0, 0, 0, 0, 0);
+  return addr == -1 ? 0 : (void*)addr;
+}
+
+int shm_close(void* addr) {
+  return do_user_call(SYS_user_shm_close, (uint64)addr, 0, 0, 0, 0, 0, 0);
+}
+
+//
+// pipes, see user_lib.h
+//
+int pipe(int fds[2]) {
+  return do_user_call(SYS_user_pipe, (uint64)fds, 0, 0, 0, 0, 0, 0);
+}
+
+long read(int fd, void* buf, unsigned long n) {
+  return do_user_call(SYS_user_read, fd, (uint64)buf, n, 0, 0, 0, 0);
+}
+
+long write(int fd, const void* buf, unsigned long n) {
+  return do_user_call(SYS_user_write, fd, (uint64)buf, n, 0, 0, 0, 0);
+}
+
+int close(int fd) {
+  return do_user_call(SYS_user_close, fd, 0, 0, 0, 0, 0, 0);
+}
+
+long splice(int fd, const char* path, unsigned long n) {
+  return do_user_call(SYS_user_splice, fd, (uint64)path, n, 0, 0, 0, 0);
+}
+
+//
+// sleep, see user_lib.h
+//
+int nanosleep(unsigned long ns) {
+  return do_user_call(SYS_user_nanosleep, ns, 0, 0, 0, 0, 0, 0);
+}
+
+//
+// select a hardware event for a performance counter, see user_lib.h
+//
+int perf_open(unsigned long event) {
+  return do_user_call(SYS_user_perf_open, event, 0, 0, 0, 0, 0, 0);
+}
+
+int perf_close(int counter) {
+  return do_user_call(SYS_user_perf_close, counter, 0, 0, 0, 0, 0, 0);
+}
+
+int perf_read(int counter, unsigned long* value) {
+  return do_user_call(SYS_user_perf_read, counter, (uint64)value, 0, 0, 0, 0, 0);
+}
+
+//
+// read a performance counter directly, without entering the kernel
+//
+unsigned long read_hpmcounter(int counter) {
+  unsigned long x = 0;
+  switch (counter) {
+#define X(n)                                            \
+  case n:                                               \
+    asm volatile("csrr %0, hpmcounter" #n : "=r"(x));   \
+    break;
+    HPM_COUNTERS(X)
+#undef X
+  }
+  return x;
+}
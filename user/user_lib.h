@@ -1,6 +1,101 @@
 /*
  * header file to be used by applications.
  */
+#ifndef _USER_LIB_H_
+#define _USER_LIB_H_
+
+#include "kernel/auxv.h"
+#include "kernel/kinfo.h"
 
 int printu(const char *s, ...);
 int exit(int code);
+int trace_dump(const char *path);
+int yield(void);
+
+// host files, opened for reading. file_open() returns a descriptor, or -1, and file_pread()
+// reads up to n bytes at offset off into buf, returning the bytes read, or -1.
+int file_open(const char *path);
+long file_pread(int fd, void *buf, unsigned long n, unsigned long off);
+int file_close(int fd);
+
+// the environment of the application (NAME=value strings, ended by a NULL), and the value
+// of one of its variables, or NULL if not set. the kernel takes the environment from the
+// NAME=value strings in front of the application on the command line.
+extern char **environ;
+char *getenv(const char *name);
+// the value of the entry of the auxiliary vector of type (AT_* in kernel/auxv.h), or 0
+unsigned long getauxval(unsigned long type);
+
+// read without a syscall, from the kernel info page (see kernel/kinfo.h). kinfo_page()
+// returns the page itself, and kinfo_snapshot() copies it consistently to *k.
+const kinfo *kinfo_page(void);
+void kinfo_snapshot(kinfo *k);
+int getpid(void);
+int gethart(void);
+
+// both clocks count the time since boot, from the time counter
+#define CLOCK_REALTIME 0
+#define CLOCK_MONOTONIC 1
+
+struct timespec {
+  long tv_sec;
+  long tv_nsec;
+};
+
+// returns 0, or -1 for an unknown clock
+int clock_gettime(int clock, struct timespec *ts);
+
+// sleep while *addr == expected, for at most timeout timer ticks (0: no limit), returns 0
+// when woken by futex_wake(). wake up to n sleepers on addr, returns how many woke up.
+int futex_wait(int *addr, int expected, unsigned long timeout);
+int futex_wake(int *addr, int n);
+
+// named shared memory: the address of the region called name, created zero-filled with
+// at least size bytes if it does not exist, or 0 on failure
+void *shm_open(const char *name, unsigned long size);
+int shm_close(void *addr);
+
+// pipes. read() of an empty pipe and write() to a full one return -1 while the other end
+// is open, instead of blocking. whole, page-aligned pages of a write are gifted to the pipe
+// without a copy, and must be left alone until read. splice() appends up to n bytes of the
+// pipe to the host file at path, without passing them through user memory.
+// descriptors 0, 1 and 2 are the console, which read() waits for.
+#define STDIN_FILENO 0
+#define STDOUT_FILENO 1
+#define STDERR_FILENO 2
+int pipe(int fds[2]);
+long read(int fd, void *buf, unsigned long n);
+long write(int fd, const void *buf, unsigned long n);
+int close(int fd);
+long splice(int fd, const char *path, unsigned long n);
+
+// sleep for at least ns nanoseconds (rounded up to kernel timer ticks)
+int nanosleep(unsigned long ns);
+
+// performance counters. perf_open() counts a hardware event (implementation defined, as
+// programmed into mhpmevent) and returns the number of the counter, or -1. the counters are
+// read without a syscall: read_hpmcounter(counter), or read_cycle() and friends.
+int perf_open(unsigned long event);
+int perf_close(int counter);
+int perf_read(int counter, unsigned long *value);
+unsigned long read_hpmcounter(int counter);
+
+static inline unsigned long read_cycle(void) {
+  unsigned long x;
+  asm volatile("rdcycle %0" : "=r"(x));
+  return x;
+}
+
+static inline unsigned long read_instret(void) {
+  unsigned long x;
+  asm volatile("rdinstret %0" : "=r"(x));
+  return x;
+}
+
+static inline unsigned long read_time(void) {
+  unsigned long x;
+  asm volatile("rdtime %0" : "=r"(x));
+  return x;
+}
+
+#endif
@@ -0,0 +1,120 @@
+/*
+ * user-level synchronization on futexes (kernel/futex.c). the mutex is the three-state one
+ * of Drepper's "Futexes Are Tricky": unlock makes a futex_wake syscall only if a locker
+ * marked the mutex contended.
+ *
+ * the holder may be another green thread (user/uthread.c) of this process, which runs only
+ * when we yield: futex_wait() would stop the whole process, holder included. a waiter
+ * therefore yields while other threads can run, and sleeps on the futex only when the
+ * holder can be in another process.
+ */
+
+#include "usync.h"
+#include "user_lib.h"
+#include "uthread.h"
+
+// timer ticks to sleep in one futex_wait. waiters recheck and sleep again, so this bounds
+// only the delay of a missed wakeup.
+#define USYNC_SLEEP_TICKS 10
+
+usync_stats g_usync_stats;
+
+static int cas(int *p, int expected, int desired) {
+  __atomic_compare_exchange_n(p, &expected, desired, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+  return expected;
+}
+
+static int xchg(int *p, int v) { return __atomic_exchange_n(p, v, __ATOMIC_ACQUIRE); }
+
+static void sleep_on(int *addr, int expected) {
+  if (thread_runnable() > 1) {
+    g_usync_stats.yields++;
+    thread_yield();
+    return;
+  }
+  g_usync_stats.sleeps++;
+  futex_wait(addr, expected, USYNC_SLEEP_TICKS);
+}
+
+static void wake(int *addr, int n) {
+  g_usync_stats.wakes++;
+  futex_wake(addr, n);
+}
+
+void umutex_lock(umutex *m) {
+  g_usync_stats.acquires++;
+  int s = cas(&m->state, 0, 1);
+  if (s == 0) return;
+
+  g_usync_stats.contended++;
+  if (s != 2) s = xchg(&m->state, 2);
+  while (s != 0) {
+    sleep_on(&m->state, 2);
+    s = xchg(&m->state, 2);
+  }
+}
+
+int umutex_trylock(umutex *m) {
+  g_usync_stats.acquires++;
+  if (cas(&m->state, 0, 1) == 0) return 0;
+  g_usync_stats.contended++;
+  return -1;
+}
+
+void umutex_unlock(umutex *m) {
+  if (__atomic_fetch_sub(&m->state, 1, __ATOMIC_RELEASE) != 1) {
+    __atomic_store_n(&m->state, 0, __ATOMIC_RELEASE);
+    wake(&m->state, 1);
+  }
+}
+
+void ucond_wait(ucond *c, umutex *m) {
+  int seq = __atomic_load_n(&c->seq, __ATOMIC_RELAXED);
+  umutex_unlock(m);
+  sleep_on(&c->seq, seq);
+  umutex_lock(m);
+}
+
+void ucond_signal(ucond *c) {
+  __atomic_fetch_add(&c->seq, 1, __ATOMIC_RELEASE);
+  wake(&c->seq, 1);
+}
+
+void ucond_broadcast(ucond *c) {
+  __atomic_fetch_add(&c->seq, 1, __ATOMIC_RELEASE);
+  wake(&c->seq, 1 << 30);
+}
+
+void usem_init(usem *s, int count) {
+  s->count = count;
+  s->waiters = 0;
+}
+
+void usem_wait(usem *s) {
+  g_usync_stats.acquires++;
+  int n = __atomic_load_n(&s->count, __ATOMIC_RELAXED);
+  if (n > 0 && cas(&s->count, n, n - 1) == n) return;
+
+  g_usync_stats.contended++;
+  __atomic_fetch_add(&s->waiters, 1, __ATOMIC_RELAXED);
+  for (;;) {
+    n = __atomic_load_n(&s->count, __ATOMIC_RELAXED);
+    if (n > 0) {
+      if (cas(&s->count, n, n - 1) == n) break;
+      continue;
+    }
+    sleep_on(&s->count, 0);
+  }
+  __atomic_fetch_sub(&s->waiters, 1, __ATOMIC_RELAXED);
+}
+
+void usem_post(usem *s) {
+  __atomic_fetch_add(&s->count, 1, __ATOMIC_RELEASE);
+  if (__atomic_load_n(&s->waiters, __ATOMIC_RELAXED)) wake(&s->count, 1);
+}
+
+void usync_print_stats(void) {
+  printu("usync: %ld acquires, %ld contended, %ld yields, %ld futex waits, %ld futex wakes\n",
+         g_usync_stats.acquires, g_usync_stats.contended, g_usync_stats.yields,
+         g_usync_stats.sleeps, g_usync_stats.wakes);
+}
@@ -0,0 +1,50 @@
+/*
+ * mutexes, condition variables and semaphores that take and give with AMOs in user space,
+ * and make a futex syscall only when a thread has to sleep or to wake someone.
+ * all of them are zero-initialized, a semaphore then sets its count.
+ */
+#ifndef _USYNC_H_
+#define _USYNC_H_
+
+// state: 0 unlocked, 1 locked, 2 locked and maybe contended (someone may sleep on it)
+typedef struct umutex_t {
+  int state;
+} umutex;
+
+// seq changes on every signal and broadcast, so a waiter sleeping on an old value wakes up
+typedef struct ucond_t {
+  int seq;
+} ucond;
+
+typedef struct usem_t {
+  int count;
+  int waiters;
+} usem;
+
+void umutex_lock(umutex *m);
+// returns 0 if m was taken, -1 if it is busy
+int umutex_trylock(umutex *m);
+void umutex_unlock(umutex *m);
+
+// release m, sleep until signaled, and take m again. spurious wakeups are possible.
+void ucond_wait(ucond *c, umutex *m);
+void ucond_signal(ucond *c);
+void ucond_broadcast(ucond *c);
+
+void usem_init(usem *s, int count);
+void usem_wait(usem *s);
+void usem_post(usem *s);
+
+// contention statistics, summed over all objects
+typedef struct usync_stats_t {
+  unsigned long acquires;   // mutex locks and semaphore waits
+  unsigned long contended;  // those that found the object busy
+  unsigned long yields;     // waits that let another green thread run
+  unsigned long sleeps;     // futex_wait syscalls
+  unsigned long wakes;      // futex_wake syscalls
+} usync_stats;
+
+extern usync_stats g_usync_stats;
+void usync_print_stats(void);
+
+#endif
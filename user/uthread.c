@@ -0,0 +1,159 @@
+/*
+ * green threads of the user library. the threads are switched by uthread_switch()
+ * (user/uthread_switch.S), which saves only the callee-saved registers: a switch is a
+ * function call, so the others are already saved by the compiler where needed.
+ *
+ * the callee-saved FP registers are saved and loaded as well, but only for the threads
+ * flagged UTHREAD_FP: touching them would have the kernel give the process the FP unit (see
+ * kernel/fp.c), which the threads that do not use FP can do without.
+ */
+
+#include "uthread.h"
+#include "user_lib.h"
+#include "util/types.h"
+
+// registers saved by uthread_switch(), in its order, and by uthread_save_fp()
+typedef struct uthread_context_t {
+  uint64 ra, sp;
+  uint64 s[12];
+  uint64 fs[12];
+} uthread_context;
+
+void uthread_switch(uthread_context *from, uthread_context *to);
+void uthread_save_fp(uint64 *fs);
+void uthread_load_fp(const uint64 *fs);
+
+enum uthread_state { T_FREE = 0, T_RUNNABLE, T_DONE };
+
+typedef struct uthread_t {
+  uthread_context ctx;
+  enum uthread_state state;
+  int stack;  // slot in the stack pool, -1 for the main thread
+  int flags;  // UTHREAD_FP
+  void (*fn)(void *);
+  void *arg;
+} uthread;
+
+static uthread threads[UTHREAD_MAX] = {[0] = {.state = T_RUNNABLE, .stack = -1}};
+static int cur = 0;
+
+// the stack pool: fixed-size stacks, and a free list of their slots
+static char stacks[UTHREAD_MAX - 1][UTHREAD_STACK_SIZE] __attribute__((aligned(16)));
+static int stack_next[UTHREAD_MAX - 1];
+static int stack_free = -1, stack_inited = 0;
+
+static int stack_alloc(void) {
+  if (!stack_inited) {
+    for (int i = 0; i < UTHREAD_MAX - 1; i++) stack_next[i] = i + 1 < UTHREAD_MAX - 1 ? i + 1 : -1;
+    stack_free = 0;
+    stack_inited = 1;
+  }
+  int slot = stack_free;
+  if (slot >= 0) stack_free = stack_next[slot];
+  return slot;
+}
+
+static void stack_release(int slot) {
+  stack_next[slot] = stack_free;
+  stack_free = slot;
+}
+
+// where a new thread starts, "returning" from its first uthread_switch()
+static void thread_entry(void) {
+  threads[cur].fn(threads[cur].arg);
+  thread_exit();
+}
+
+int thread_create(void (*fn)(void *), void *arg) { return thread_create_flags(fn, arg, 0); }
+
+int thread_create_flags(void (*fn)(void *), void *arg, int flags) {
+  int tid;
+  for (tid = 1; tid < UTHREAD_MAX && threads[tid].state != T_FREE; tid++)
+    ;
+  if (tid == UTHREAD_MAX) return -1;
+  int slot = stack_alloc();
+  if (slot < 0) return -1;
+
+  uthread *t = &threads[tid];
+  t->ctx = (uthread_context){0};
+  t->ctx.ra = (uint64)thread_entry;
+  t->ctx.sp = (uint64)(stacks[slot] + UTHREAD_STACK_SIZE);
+  t->stack = slot;
+  t->flags = flags;
+  t->fn = fn;
+  t->arg = arg;
+  t->state = T_RUNNABLE;
+  return tid;
+}
+
+// switch to the next runnable thread after the current one, round robin
+static void schedule(void) {
+  int prev = cur, next = cur;
+  do {
+    next = (next + 1) % UTHREAD_MAX;
+  } while (threads[next].state != T_RUNNABLE && next != prev);
+  if (next == prev) return;
+
+  cur = next;
+  // schedule() does not use FP itself, so the FP registers still hold those of prev, and
+  // hold those of next when it returns here
+  if (threads[prev].flags & UTHREAD_FP) uthread_save_fp(threads[prev].ctx.fs);
+  if (threads[next].flags & UTHREAD_FP) uthread_load_fp(threads[next].ctx.fs);
+  uthread_switch(&threads[prev].ctx, &threads[next].ctx);
+}
+
+void thread_yield(void) { schedule(); }
+
+void thread_use_fp(void) { threads[cur].flags |= UTHREAD_FP; }
+
+void thread_exit(void) {
+  threads[cur].state = T_DONE;
+  schedule();
+  // the last thread is done, and nobody is left to join it
+  exit(0);
+}
+
+int thread_join(int tid) {
+  if (tid <= 0 || tid >= UTHREAD_MAX || tid == cur || threads[tid].state == T_FREE) return -1;
+  while (threads[tid].state != T_DONE) thread_yield();
+
+  stack_release(threads[tid].stack);
+  threads[tid].state = T_FREE;
+  return 0;
+}
+
+int thread_self(void) { return cur; }
+
+int thread_runnable(void) {
+  int n = 0;
+  for (int tid = 0; tid < UTHREAD_MAX; tid++) n += threads[tid].state == T_RUNNABLE;
+  return n;
+}
+
+void mutex_lock(mutex *m) {
+  // threads switch only when they yield, so test-and-set needs no atomics
+  while (m->locked) thread_yield();
+  m->locked = 1;
+}
+
+void mutex_unlock(mutex *m) { m->locked = 0; }
+
+void chan_init(chan *c, long *buf, int cap) {
+  c->buf = buf;
+  c->cap = cap;
+  c->head = c->count = 0;
+}
+
+void chan_send(chan *c, long v) {
+  while (c->count == c->cap) thread_yield();
+  c->buf[(c->head + c->count) % c->cap] = v;
+  c->count++;
+}
+
+long chan_recv(chan *c) {
+  while (c->count == 0) thread_yield();
+  long v = c->buf[c->head];
+  c->head = (c->head + 1) % c->cap;
+  c->count--;
+  return v;
+}
@@ -0,0 +1,54 @@
+/*
+ * green threads (M:1): threads of the user library, all run by the one process, and
+ * switched only when they call thread_yield() or block on a mutex or a channel.
+ */
+#ifndef _UTHREAD_H_
+#define _UTHREAD_H_
+
+#define UTHREAD_MAX 16            // including the main thread
+#define UTHREAD_STACK_SIZE 16384  // bytes of stack per thread
+
+// start fn(arg) in a new thread. returns its id, or -1 if UTHREAD_MAX threads exist.
+int thread_create(void (*fn)(void *), void *arg);
+// the same, with flags. a thread that uses the FP registers (float or double code) must be
+// created with UTHREAD_FP, for them to be switched with it. the others leave them alone,
+// so that a process whose threads do not use FP never has the kernel load the FP unit.
+#define UTHREAD_FP 1
+int thread_create_flags(void (*fn)(void *), void *arg, int flags);
+// mark the calling thread, e.g., the main one, as using the FP registers (UTHREAD_FP)
+void thread_use_fp(void);
+// let the other runnable threads run
+void thread_yield(void);
+// wait for thread tid to finish, and reclaim its stack. returns -1 for a bad tid.
+int thread_join(int tid);
+// finish the calling thread, as returning from its fn does
+void thread_exit(void) __attribute__((noreturn));
+// id of the calling thread, the main thread is 0
+int thread_self(void);
+// number of threads that can run, the calling one included. while others can, a thread
+// waiting on a user-level lock (user/usync.c, user/uring.c) yields to them instead of
+// sleeping in the kernel, which would stop the whole process.
+int thread_runnable(void);
+
+// a mutex, to be zero-initialized. waiters yield instead of spinning.
+typedef struct mutex_t {
+  int locked;
+} mutex;
+
+void mutex_lock(mutex *m);
+void mutex_unlock(mutex *m);
+
+// a channel of cap longs, kept in buf
+typedef struct chan_t {
+  long *buf;
+  int cap;
+  int head, count;
+} chan;
+
+void chan_init(chan *c, long *buf, int cap);
+// send v, yielding while the channel is full
+void chan_send(chan *c, long v);
+// receive a value, yielding while the channel is empty
+long chan_recv(chan *c);
+
+#endif
@@ -1,5 +1,11 @@
 /*
- * vsnprintf() is borrowed from pk.
+ * vsnprintf() is borrowed from pk, and reworked for speed: runs of literal characters are
+ * copied with one memcpy, and decimals are produced two digits at a time from a table.
+ *
+ * supported conversions: %d %i %u %x %X %o %p %s %c %%, with the flags "-+ 0#", field
+ * width and precision (both may be "*"), and the length modifiers hh h l ll z j t.
+ * like the C library, the return value is the length of the full output, even when it
+ * does not fit in n bytes, so snprintf(NULL, 0, ...) tells the size needed.
  */
 
 //#include <stdint.h>
@@ -7,77 +13,246 @@
 //#include <stdbool.h>
 
 #include "util/snprintf.h"
+#include "util/string.h"
 
-int32 vsnprintf(char* out, size_t n, const char* s, va_list vl) {
-  bool format = FALSE;
-  bool longarg = FALSE;
-  size_t pos = 0;
-
-  for (; *s; s++) {
-    if (format) {
-      switch (*s) {
-        case 'l':
-          longarg = TRUE;
-          break;
-        case 'p':
-          longarg = TRUE;
-          if (++pos < n) out[pos - 1] = '0';
-          if (++pos < n) out[pos - 1] = 'x';
-        case 'x': {
-          long num = longarg ? va_arg(vl, long) : va_arg(vl, int);
-          for (int i = 2 * (longarg ? sizeof(long) : sizeof(int)) - 1; i >= 0; i--) {
-            int d = (num >> (4 * i)) & 0xF;
-            if (++pos < n) out[pos - 1] = (d < 10 ? '0' + d : 'a' + d - 10);
-          }
-          longarg = FALSE;
-          format = FALSE;
-          break;
-        }
-        case 'd': {
-          long num = longarg ? va_arg(vl, long) : va_arg(vl, int);
-          if (num < 0) {
-            num = -num;
-            if (++pos < n) out[pos - 1] = '-';
-          }
-          long digits = 1;
-          for (long nn = num; nn /= 10; digits++)
-            ;
-          for (int i = digits - 1; i >= 0; i--) {
-            if (pos + i + 1 < n) out[pos + i] = '0' + (num % 10);
-            num /= 10;
-          }
-          pos += digits;
-          longarg = FALSE;
-          format = FALSE;
-          break;
-        }
-        case 's': {
-          const char* s2 = va_arg(vl, const char*);
-          while (*s2) {
-            if (++pos < n) out[pos - 1] = *s2;
-            s2++;
-          }
-          longarg = FALSE;
-          format = FALSE;
-          break;
+#define FL_LEFT 0x01   // '-': left-justify in the field
+#define FL_PLUS 0x02   // '+': always print a sign
+#define FL_SPACE 0x04  // ' ': a space in place of '+'
+#define FL_ZERO 0x08   // '0': pad with zeros instead of spaces
+#define FL_ALT 0x10    // '#': 0x / 0 prefix for hex / octal
+
+// "00" "01" ... "99"
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// the output buffer. pos counts every character produced, stored or not.
+typedef struct outbuf_t {
+  char* out;
+  size_t n;
+  size_t pos;
+} outbuf;
+
+static void put_run(outbuf* b, const char* s, size_t len) {
+  if (b->pos + 1 < b->n) {
+    size_t room = b->n - 1 - b->pos;
+    memcpy(b->out + b->pos, s, len < room ? len : room);
+  }
+  b->pos += len;
+}
+
+static void put_fill(outbuf* b, char c, long count) {
+  if (count <= 0) return;
+  if (b->pos + 1 < b->n) {
+    size_t room = b->n - 1 - b->pos;
+    memset(b->out + b->pos, c, (size_t)count < room ? (size_t)count : room);
+  }
+  b->pos += count;
+}
+
+// write v in decimal, ending right before end. returns the first digit.
+static char* fmt_dec(char* end, uint64 v) {
+  while (v >= 100) {
+    uint64 q = v / 100;
+    uint32 r = (uint32)(v - q * 100) * 2;
+    end -= 2;
+    end[0] = digit_pairs[r];
+    end[1] = digit_pairs[r + 1];
+    v = q;
+  }
+  if (v >= 10) {
+    end -= 2;
+    end[0] = digit_pairs[v * 2];
+    end[1] = digit_pairs[v * 2 + 1];
+  } else {
+    *--end = '0' + v;
+  }
+  return end;
+}
+
+static char* fmt_base2(char* end, uint64 v, int bits, int upper) {
+  const char* digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+  uint64 mask = (1 << bits) - 1;
+  do {
+    *--end = digits[v & mask];
+    v >>= bits;
+  } while (v);
+  return end;
+}
+
+// emit the digits [start, end) with sign/prefix, precision and width applied
+static void put_number(outbuf* b, const char* start, const char* end, const char* prefix,
+                       int flags, int width, int prec) {
+  long len = end - start;
+  long prefix_len = strlen(prefix);
+  long zeros = prec > len ? prec - len : 0;
+  long pad = width - (prefix_len + zeros + len);
+
+  if ((flags & (FL_ZERO | FL_LEFT)) == FL_ZERO && prec < 0) {
+    zeros += pad > 0 ? pad : 0;
+    pad = 0;
+  }
+  if (!(flags & FL_LEFT)) put_fill(b, ' ', pad);
+  put_run(b, prefix, prefix_len);
+  put_fill(b, '0', zeros);
+  put_run(b, start, len);
+  if (flags & FL_LEFT) put_fill(b, ' ', pad);
+}
+
+int vsnprintf(char* out, size_t n, const char* s, va_list vl) {
+  outbuf b = {out, n, 0};
+
+  while (*s) {
+    // copy the literal run up to the next conversion in one go
+    const char* lit = s;
+    while (*s && *s != '%') s++;
+    if (s != lit) put_run(&b, lit, s - lit);
+    if (!*s) break;
+
+    // *s == '%', parse "%[flags][width][.precision][length]conversion"
+    const char* spec = s++;
+    int flags = 0;
+    for (;; s++) {
+      if (*s == '-') flags |= FL_LEFT;
+      else if (*s == '+') flags |= FL_PLUS;
+      else if (*s == ' ') flags |= FL_SPACE;
+      else if (*s == '0') flags |= FL_ZERO;
+      else if (*s == '#') flags |= FL_ALT;
+      else break;
+    }
+
+    int width = 0;
+    if (*s == '*') {
+      width = va_arg(vl, int);
+      if (width < 0) {
+        flags |= FL_LEFT;
+        width = -width;
+      }
+      s++;
+    } else {
+      for (; *s >= '0' && *s <= '9'; s++) width = width * 10 + (*s - '0');
+    }
+
+    int prec = -1;
+    if (*s == '.') {
+      s++;
+      prec = 0;
+      if (*s == '*') {
+        prec = va_arg(vl, int);
+        if (prec < 0) prec = -1;
+        s++;
+      } else {
+        for (; *s >= '0' && *s <= '9'; s++) prec = prec * 10 + (*s - '0');
+      }
+    }
+
+    // argument size: 0 int, 1 long (l, ll, z, j, t), -1 short, -2 char
+    int size = 0;
+    for (;; s++) {
+      if (*s == 'l' || *s == 'z' || *s == 'j' || *s == 't') size = 1;
+      else if (*s == 'h') size = size < 0 ? -2 : -1;
+      else break;
+    }
+
+    char buf[24];  // enough for 2^64 in octal
+    char* end = buf + sizeof(buf);
+    const char* prefix = "";
+    uint64 num;
+
+    switch (*s) {
+      case 'd':
+      case 'i': {
+        int64 v = size > 0 ? va_arg(vl, long) : va_arg(vl, int);
+        if (size == -1) v = (int16)v;
+        if (size == -2) v = (int8)v;
+        num = v < 0 ? -(uint64)v : (uint64)v;
+        if (v < 0) prefix = "-";
+        else if (flags & FL_PLUS) prefix = "+";
+        else if (flags & FL_SPACE) prefix = " ";
+        char* start = (num == 0 && prec == 0) ? end : fmt_dec(end, num);
+        put_number(&b, start, end, prefix, flags, width, prec);
+        break;
+      }
+      case 'u':
+      case 'x':
+      case 'X':
+      case 'o': {
+        num = size > 0 ? va_arg(vl, unsigned long) : va_arg(vl, unsigned int);
+        if (size == -1) num = (uint16)num;
+        if (size == -2) num = (uint8)num;
+        char* start = end;
+        if (num != 0 || prec != 0) {
+          if (*s == 'u') start = fmt_dec(end, num);
+          else if (*s == 'o') start = fmt_base2(end, num, 3, 0);
+          else start = fmt_base2(end, num, 4, *s == 'X');
         }
-        case 'c': {
-          if (++pos < n) out[pos - 1] = (char)va_arg(vl, int);
-          longarg = FALSE;
-          format = FALSE;
-          break;
+        if ((flags & FL_ALT) && num != 0) {
+          if (*s == 'x') prefix = "0x";
+          if (*s == 'X') prefix = "0X";
         }
-        default:
-          break;
+        if ((flags & FL_ALT) && *s == 'o' && (start == end || *start != '0')) *--start = '0';
+        put_number(&b, start, end, prefix, flags, width, prec);
+        break;
+      }
+      case 'p': {
+        // pointers are always printed in full, e.g., 0x0000000080000000
+        num = (uint64)va_arg(vl, void*);
+        char* start = fmt_base2(end, num, 4, 0);
+        put_number(&b, start, end, "0x", flags & FL_LEFT, width, 2 * sizeof(void*));
+        break;
+      }
+      case 's': {
+        const char* str = va_arg(vl, const char*);
+        if (!str) str = "(null)";
+        size_t len = 0;
+        while (str[len] && (prec < 0 || len < (size_t)prec)) len++;
+        long pad = width - (long)len;
+        if (!(flags & FL_LEFT)) put_fill(&b, ' ', pad);
+        put_run(&b, str, len);
+        if (flags & FL_LEFT) put_fill(&b, ' ', pad);
+        break;
+      }
+      case 'c': {
+        char c = (char)va_arg(vl, int);
+        if (!(flags & FL_LEFT)) put_fill(&b, ' ', width - 1);
+        put_run(&b, &c, 1);
+        if (flags & FL_LEFT) put_fill(&b, ' ', width - 1);
+        break;
       }
-    } else if (*s == '%')
-      format = TRUE;
-    else if (++pos < n)
-      out[pos - 1] = *s;
+      case '%':
+        put_run(&b, "%", 1);
+        break;
+      default:
+        // unknown conversion: print it as it is
+        if (!*s) {
+          put_run(&b, spec, s - spec);
+          continue;
+        }
+        put_run(&b, spec, s + 1 - spec);
+        break;
+    }
+    s++;
   }
-  if (pos < n)
-    out[pos] = 0;
+
+  if (b.pos < n)
+    out[b.pos] = 0;
   else if (n)
     out[n - 1] = 0;
-  return pos;
+  return b.pos;
+}
+
+int snprintf(char* out, size_t n, const char* s, ...) {
+  va_list vl;
+  va_start(vl, s);
+  int res = vsnprintf(out, n, s, vl);
+  va_end(vl);
+  return res;
 }
@@ -7,5 +7,6 @@
 #include "util/types.h"
 
 int vsnprintf(char* out, size_t n, const char* s, va_list vl);
+int snprintf(char* out, size_t n, const char* s, ...);
 
 #endif
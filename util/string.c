@@ -5,48 +5,162 @@
 
 #include "string.h"
 
-void* memcpy(void* dest, const void* src, size_t len) {
-  const char* s = src;
+#define WSIZE sizeof(uintptr_t)
+
+// HASZERO(w) is nonzero iff one of the bytes of word w is 0
+#define ONES ((uintptr_t)-1 / 0xFF)
+#define HIGHS (ONES << 7)
+#define HASZERO(w) (((w) - ONES) & ~(w) & HIGHS)
+
+// vector versions of the routines below, implemented in util/string_rvv.S
+void* memcpy_rvv(void* dest, const void* src, size_t len);
+void* memset_rvv(void* dest, int byte, size_t len);
+void* memmove_rvv(void* dest, const void* src, size_t len);
+size_t strlen_rvv(const char* s);
+
+// whether the vector versions may be used. see string_enable_vector().
+static int use_vector;
+
+void string_enable_vector(void) { use_vector = 1; }
+void string_disable_vector(void) { use_vector = 0; }
+int string_vector_enabled(void) { return use_vector; }
+
+static void* memcpy_scalar(void* dest, const void* src, size_t len) {
   char* d = dest;
+  const char* s = src;
 
-  if ((((uintptr_t)dest | (uintptr_t)src) & (sizeof(uintptr_t) - 1)) == 0) {
-    while ((void*)d < (dest + len - (sizeof(uintptr_t) - 1))) {
-      *(uintptr_t*)d = *(const uintptr_t*)s;
-      d += sizeof(uintptr_t);
-      s += sizeof(uintptr_t);
+  if (len >= 2 * WSIZE) {
+    // copy bytes until the destination is word aligned
+    for (; (uintptr_t)d & (WSIZE - 1); len--) *d++ = *s++;
+
+    uintptr_t* dw = (uintptr_t*)d;
+    size_t shift = ((uintptr_t)s & (WSIZE - 1)) * 8;
+    if (shift == 0) {
+      const uintptr_t* sw = (const uintptr_t*)s;
+      for (; len >= 4 * WSIZE; len -= 4 * WSIZE, dw += 4, sw += 4) {
+        uintptr_t w0 = sw[0], w1 = sw[1], w2 = sw[2], w3 = sw[3];
+        dw[0] = w0;
+        dw[1] = w1;
+        dw[2] = w2;
+        dw[3] = w3;
+      }
+      for (; len >= WSIZE; len -= WSIZE) *dw++ = *sw++;
+      s = (const char*)sw;
+    } else {
+      // the source is not aligned with the destination: load aligned source words, and
+      // merge each pair of neighbours into one destination word (little endian). no word
+      // beyond the one holding the last byte to copy is ever loaded.
+      const uintptr_t* sw = (const uintptr_t*)((uintptr_t)s & ~(WSIZE - 1));
+      uintptr_t lo = *sw++;
+      for (; len >= 2 * WSIZE; len -= 2 * WSIZE, dw += 2, sw += 2) {
+        uintptr_t mid = sw[0], hi = sw[1];
+        dw[0] = (lo >> shift) | (mid << (8 * WSIZE - shift));
+        dw[1] = (mid >> shift) | (hi << (8 * WSIZE - shift));
+        lo = hi;
+      }
+      for (; len >= WSIZE; len -= WSIZE) {
+        uintptr_t hi = *sw++;
+        *dw++ = (lo >> shift) | (hi << (8 * WSIZE - shift));
+        lo = hi;
+      }
+      s = (const char*)sw - WSIZE + shift / 8;
     }
+    d = (char*)dw;
   }
 
-  while (d < (char*)(dest + len)) *d++ = *s++;
+  while (len--) *d++ = *s++;
 
   return dest;
 }
 
-void* memset(void* dest, int byte, size_t len) {
-  if ((((uintptr_t)dest | len) & (sizeof(uintptr_t) - 1)) == 0) {
+void* memcpy(void* dest, const void* src, size_t len) {
+  if (use_vector) return memcpy_rvv(dest, src, len);
+  return memcpy_scalar(dest, src, len);
+}
+
+static void* memset_scalar(void* dest, int byte, size_t len) {
+  char* d = dest;
+
+  if (len >= 2 * WSIZE) {
     uintptr_t word = byte & 0xFF;
     word |= word << 8;
     word |= word << 16;
     word |= word << 16 << 16;
 
-    uintptr_t* d = dest;
-    while (d < (uintptr_t*)(dest + len)) *d++ = word;
-  } else {
-    char* d = dest;
-    while (d < (char*)(dest + len)) *d++ = byte;
+    for (; (uintptr_t)d & (WSIZE - 1); len--) *d++ = byte;
+
+    uintptr_t* dw = (uintptr_t*)d;
+    for (; len >= 4 * WSIZE; len -= 4 * WSIZE, dw += 4) {
+      dw[0] = word;
+      dw[1] = word;
+      dw[2] = word;
+      dw[3] = word;
+    }
+    for (; len >= WSIZE; len -= WSIZE) *dw++ = word;
+    d = (char*)dw;
   }
+
+  while (len--) *d++ = byte;
+
   return dest;
 }
 
+void* memset(void* dest, int byte, size_t len) {
+  if (use_vector) return memset_rvv(dest, byte, len);
+  return memset_scalar(dest, byte, len);
+}
+
+int memcmp(const void* s1, const void* s2, size_t len) {
+  const unsigned char* p1 = s1;
+  const unsigned char* p2 = s2;
+
+  for (; len; len--, p1++, p2++)
+    if (*p1 != *p2) return *p1 - *p2;
+  return 0;
+}
+
 size_t strlen(const char* s) {
+  if (use_vector) return strlen_rvv(s);
+
   const char* p = s;
-  while (*p) p++;
+
+  // aligned head: bytes up to the first word boundary
+  for (; (uintptr_t)p & (WSIZE - 1); p++)
+    if (!*p) return p - s;
+
+  // aligned body: a whole aligned word never crosses a page, so reading past the NUL inside
+  // the last word is harmless
+  const uintptr_t* w = (const uintptr_t*)p;
+  while (!HASZERO(*w)) w++;
+
+  // tail: locate the NUL in the last word
+  for (p = (const char*)w; *p; p++)
+    ;
   return p - s;
 }
 
 int strcmp(const char* s1, const char* s2) {
   unsigned char c1, c2;
 
+  // compare a word at a time when both strings can be word aligned together
+  if ((((uintptr_t)s1 ^ (uintptr_t)s2) & (WSIZE - 1)) == 0) {
+    for (; (uintptr_t)s1 & (WSIZE - 1); s1++, s2++) {
+      c1 = *s1;
+      c2 = *s2;
+      if (c1 == 0 || c1 != c2) return c1 - c2;
+    }
+
+    const uintptr_t* w1 = (const uintptr_t*)s1;
+    const uintptr_t* w2 = (const uintptr_t*)s2;
+    while (*w1 == *w2 && !HASZERO(*w1)) {
+      w1++;
+      w2++;
+    }
+    // the words differ or hold the end of the strings, find out where below
+    s1 = (const char*)w1;
+    s2 = (const char*)w2;
+  }
+
   do {
     c1 = *s1++;
     c2 = *s2++;
@@ -57,6 +171,19 @@ int strcmp(const char* s1, const char* s2) {
 
 char* strcpy(char* dest, const char* src) {
   char* d = dest;
+
+  if ((((uintptr_t)d ^ (uintptr_t)src) & (WSIZE - 1)) == 0) {
+    for (; (uintptr_t)src & (WSIZE - 1); d++, src++)
+      if ((*d = *src) == 0) return dest;
+
+    // copy whole words as long as they hold no NUL
+    uintptr_t* dw = (uintptr_t*)d;
+    const uintptr_t* sw = (const uintptr_t*)src;
+    for (; !HASZERO(*sw); dw++, sw++) *dw = *sw;
+    d = (char*)dw;
+    src = (const char*)sw;
+  }
+
   while ((*d++ = *src++))
     ;
   return dest;
@@ -81,30 +208,81 @@ long atol(const char* str) {
   return sign ? -res : res;
 }
 
-void* memmove(void* dst, const void* src, size_t n) {
-  const char* s;
-  char* d;
-
-  s = src;
-  d = dst;
-  if (s < d && s + n > d) {
-    s += n;
-    d += n;
-    while (n-- > 0) *--d = *--s;
-  } else
-    while (n-- > 0) *d++ = *s++;
+static void* memmove_scalar(void* dst, const void* src, size_t n) {
+  const char* s = src;
+  char* d = dst;
+
+  // memcpy_scalar() copies forwards, and every word it stores has been loaded before, so it
+  // is safe unless dst lies inside (src, src + n)
+  if (d <= s || s + n <= d) return memcpy_scalar(dst, src, n);
+
+  // backward copy, mirroring memcpy_scalar(): align the end of dst, copy words from the end,
+  // then the remaining head bytes
+  s += n;
+  d += n;
+  if (n >= 2 * WSIZE) {
+    for (; (uintptr_t)d & (WSIZE - 1); n--) *--d = *--s;
+
+    uintptr_t* dw = (uintptr_t*)d;
+    size_t shift = ((uintptr_t)s & (WSIZE - 1)) * 8;
+    if (shift == 0) {
+      const uintptr_t* sw = (const uintptr_t*)s;
+      for (; n >= 4 * WSIZE; n -= 4 * WSIZE) {
+        dw -= 4;
+        sw -= 4;
+        uintptr_t w0 = sw[0], w1 = sw[1], w2 = sw[2], w3 = sw[3];
+        dw[3] = w3;
+        dw[2] = w2;
+        dw[1] = w1;
+        dw[0] = w0;
+      }
+      for (; n >= WSIZE; n -= WSIZE) *--dw = *--sw;
+      s = (const char*)sw;
+    } else {
+      // hi is the aligned word holding the last source byte still to be copied
+      const uintptr_t* sw = (const uintptr_t*)((uintptr_t)s & ~(WSIZE - 1));
+      uintptr_t hi = *sw;
+      for (; n >= WSIZE; n -= WSIZE) {
+        uintptr_t lo = *--sw;
+        *--dw = (lo >> shift) | (hi << (8 * WSIZE - shift));
+        hi = lo;
+      }
+      s = (const char*)sw + shift / 8;
+    }
+    d = (char*)dw;
+  }
+
+  while (n--) *--d = *--s;
 
   return dst;
 }
 
+void* memmove(void* dst, const void* src, size_t n) {
+  if (use_vector) return memmove_rvv(dst, src, n);
+  return memmove_scalar(dst, src, n);
+}
+
 // Like strncpy but guaranteed to NUL-terminate.
 char* safestrcpy(char* s, const char* t, int n) {
-  char* os;
+  char* os = s;
 
-  os = s;
   if (n <= 0) return os;
-  while (--n > 0 && (*s++ = *t++) != 0)
-    ;
+  // bytes we may copy before the terminating NUL
+  size_t left = n - 1;
+
+  if ((((uintptr_t)s ^ (uintptr_t)t) & (WSIZE - 1)) == 0) {
+    for (; left && ((uintptr_t)t & (WSIZE - 1)); left--)
+      if ((*s++ = *t++) == 0) return os;
+
+    for (; left >= WSIZE; left -= WSIZE, s += WSIZE, t += WSIZE) {
+      uintptr_t w = *(const uintptr_t*)t;
+      if (HASZERO(w)) break;
+      *(uintptr_t*)s = w;
+    }
+  }
+
+  for (; left; left--)
+    if ((*s++ = *t++) == 0) return os;
   *s = 0;
   return os;
-}
\ No newline at end of file
+}
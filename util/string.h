@@ -5,6 +5,7 @@
 
 void* memcpy(void* dest, const void* src, size_t len);
 void* memset(void* dest, int byte, size_t len);
+int memcmp(const void* s1, const void* s2, size_t len);
 size_t strlen(const char* s);
 int strcmp(const char* s1, const char* s2);
 char* strcpy(char* dest, const char* src);
@@ -12,4 +13,13 @@ long atol(const char* str);
 void* memmove(void* dst, const void* src, size_t n);
 char* safestrcpy(char* s, const char* t, int n);
 
+// let the routines above use the RISC-V Vector extension. call only when V is present and
+// enabled in mstatus.VS.
+void string_enable_vector(void);
+// back to the scalar versions, e.g., once the vector registers hold the state of a user
+// process (see kernel/vector.c)
+void string_disable_vector(void);
+// 1 if the routines above run the vector versions, else 0
+int string_vector_enabled(void);
+
 #endif
\ No newline at end of file